@@ -0,0 +1,168 @@
+const { Blockchain } = require('@eosnetwork/vert')
+const { Asset, Serializer } = require('@wharfkit/antelope')
+const {
+  Chains,
+  Versions,
+  Protocols,
+  ProofcastEventAttestator,
+} = require('@pnetwork/event-attestator')
+const {
+  no0x,
+  active,
+  deploy,
+  bytes32,
+  precision,
+  getSwapMemo,
+  getOperation,
+  serializeOperation,
+  fromEthersPublicKey,
+} = require('../test/utils')
+const { measure } = require('./utils/measure')
+const { BUILD_DIR, report } = require('./utils/stages')
+
+describe('adapter benchmarks', () => {
+  const RUNS = 100
+  const xsymbol = 'XTKN'
+  const xsymbolPrecision = precision(4, xsymbol)
+  const maxSupply = Asset.from(500000000, xsymbolPrecision)
+  const minFee = Asset.from(0.0018, xsymbolPrecision)
+  const limit = Asset.from(1000000, xsymbolPrecision)
+  const tokenBytes =
+    '000000000000000000000000810090f35dfa6b18b5eb59d298e2a2443a2811e2'
+  const EOSChainId =
+    'aca376f206b8fc25a6ed44dbdc66547c36c6c33e3a119ffbeaef943642f0e906'
+
+  const user = 'user'
+  const bridge = 'adapter'
+  const xtoken = 'xtkn.token'
+  const issuer = 'issuer'
+  const recipient = 'recipient'
+  const feemanager = 'feemanager'
+  const results = {}
+
+  after(() => report(results))
+
+  // Packed size of the settle action data, which is what
+  // differs between the two encodings in the NET usage
+  const getNetBytes = (_contract, [caller, operation, metadata]) =>
+    Serializer.encode({
+      object: { caller, operation, metadata },
+      abi: _contract.abi,
+      type: 'settle',
+    }).byteArray.length
+
+  for (const protocol of ['Eos', 'EosBinary']) {
+    it(`settle of an EOS event (protocol ${protocol})`, async () => {
+      const blockchain = new Blockchain()
+      blockchain.createAccounts(user, issuer, recipient, feemanager)
+
+      const xerc20 = deploy(blockchain, xtoken, `${BUILD_DIR}/xerc20.token`)
+      const adapter = deploy(blockchain, bridge, `${BUILD_DIR}/adapter`)
+
+      const originChainId = Chains(Protocols[protocol]).Jungle
+      const ea = new ProofcastEventAttestator({
+        version: Versions.V1,
+        protocolId: Protocols[protocol],
+        chainId: originChainId,
+      })
+
+      const emitter = Buffer.from(bridge).toString('hex').padStart(64, '0')
+      const topic0 = Buffer.from('swap').toString('hex').padStart(64, '0')
+
+      await xerc20.actions.create([issuer, maxSupply]).send()
+      await xerc20.actions.setlimits([bridge, limit, limit]).send()
+      await adapter.actions
+        .create([
+          xtoken,
+          xsymbolPrecision,
+          '',
+          precision(18, 'TKN'),
+          tokenBytes,
+          minFee,
+        ])
+        .send()
+      await adapter.actions.setchainid([EOSChainId]).send()
+      await adapter.actions
+        .settee([fromEthersPublicKey(ea.signingKey.compressedPublicKey), ''])
+        .send()
+      await adapter.actions
+        .setorigin([no0x(bytes32(originChainId)), emitter, topic0])
+        .send()
+      await adapter.actions.setfeemanagr([feemanager]).send()
+
+      // Signing is kept out of the measured section
+      const settlements = [...Array(RUNS).keys()].map(_nonce => {
+        const operation = getOperation({
+          nonce: _nonce,
+          token: tokenBytes,
+          originChainId,
+          destinationChainId: Chains(Protocols.Eos).Mainnet,
+          amount: 1,
+          sender: user,
+          recipient,
+        })
+
+        const event = {
+          blockHash: operation.blockId,
+          transactionHash: operation.txId,
+          account: bridge,
+          action: 'swap',
+          data: { event_bytes: no0x(serializeOperation(operation)) },
+        }
+
+        const metadata = {
+          preimage: ea.getEventPreImage(event),
+          signature: ea.formatEosSignature(ea.sign(event)),
+        }
+
+        return [user, no0x(operation), no0x(metadata)]
+      })
+
+      results[`settle (protocol ${protocol})`] = {
+        ...(await measure(RUNS, _i =>
+          adapter.actions.settle(settlements[_i]).send(active(user)),
+        )),
+        net: getNetBytes(adapter, settlements[0]),
+      }
+    })
+  }
+
+  it('swap to an EVM chain', async () => {
+    const blockchain = new Blockchain()
+    blockchain.createAccounts(user, issuer, recipient, feemanager)
+
+    const xerc20 = deploy(blockchain, xtoken, `${BUILD_DIR}/xerc20.token`)
+    const adapter = deploy(blockchain, bridge, `${BUILD_DIR}/adapter`)
+
+    await xerc20.actions.create([issuer, maxSupply]).send()
+    await xerc20.actions.setlimits([bridge, limit, limit]).send()
+    await adapter.actions
+      .create([
+        xtoken,
+        xsymbolPrecision,
+        '',
+        precision(18, 'TKN'),
+        tokenBytes,
+        minFee,
+      ])
+      .send()
+    await adapter.actions.setfeemanagr([feemanager]).send()
+    await xerc20.actions
+      .mint([bridge, user, Asset.from(1000, xsymbolPrecision), ''])
+      .send(active(bridge))
+
+    const memo = getSwapMemo(
+      user,
+      bytes32(Chains(Protocols.Evm).Mainnet),
+      '0xe396757ec7e6ac7c8e5abe7285dde47b98f22db8',
+      '',
+    )
+    const quantity = Asset.from(1, xsymbolPrecision)
+
+    results['swap'] = await measure(RUNS, () =>
+      xerc20.actions
+        .transfer([user, bridge, quantity, memo])
+        .send(active(user)),
+    )
+  })
+})
@@ -0,0 +1,26 @@
+const fs = require('fs')
+const { replay } = require('./utils/replay')
+const { BUILD_DIR } = require('./utils/stages')
+const { getSampleLog } = require('./utils/sample-log')
+
+// Set REPLAY_LOG to the path of a recorded log (see
+// ./utils/replay.js for the format), otherwise a
+// synthetic workload is generated
+describe('replay benchmarks', () => {
+  const path = process.env.REPLAY_LOG
+
+  it(`replay of ${path || 'the sample workload'}`, async () => {
+    const log = path
+      ? JSON.parse(fs.readFileSync(path, 'utf-8'))
+      : getSampleLog()
+
+    const { flows, ...summary } = await replay(log, BUILD_DIR)
+
+    console.table({
+      'measured actions': summary.actions,
+      'throughput (actions/s)': summary.throughput,
+      'RAM growth (bytes)': summary.ram,
+    })
+    console.table(flows)
+  })
+})
@@ -0,0 +1,67 @@
+// Wraps the intrinsics that vert gives to the contracts WASM
+// instances, so that benchmarks can observe them (see stages.js
+// and ram.js). Each wrapper is built by the registered factory:
+//
+//    (_intrinsic, _instance) => function (...args) { ... }
+//
+// where _instance gives access to the instance memory and to the
+// other (not wrapped) intrinsics.
+const factories = {}
+
+const wrapImports = (_imports, _instance) => {
+  if (!_imports || !_imports.env) return _imports
+
+  const env = new Proxy(_imports.env, {
+    get: (_target, _key) => {
+      const value = Reflect.get(_target, _key)
+      return factories[_key] ? factories[_key](value, _instance) : value
+    },
+  })
+
+  _instance.env = _imports.env
+  return { ..._imports, env }
+}
+
+let installed = false
+
+const install = () => {
+  if (installed) return
+  installed = true
+
+  const { Instance, instantiate } = WebAssembly
+
+  WebAssembly.Instance = function (_module, _imports) {
+    const context = { memory: null }
+    const instance = new Instance(_module, wrapImports(_imports, context))
+    context.memory = instance.exports.memory
+    return instance
+  }
+  WebAssembly.Instance.prototype = Instance.prototype
+
+  WebAssembly.instantiate = async (_source, _imports) => {
+    const context = { memory: null }
+    const result = await instantiate(_source, wrapImports(_imports, context))
+    context.memory = (result.instance || result).exports.memory
+    return result
+  }
+}
+
+// Must be called before the contracts are deployed
+const hook = (_name, _factory) => {
+  install()
+  factories[_name] = _factory
+}
+
+const readString = (_memory, _ptr, _len) =>
+  Buffer.from(_memory.buffer, _ptr, _len).toString()
+
+const readCString = (_memory, _ptr) => {
+  const view = new Uint8Array(_memory.buffer)
+  return readString(_memory, _ptr, view.indexOf(0, _ptr) - _ptr)
+}
+
+module.exports = {
+  hook,
+  readString,
+  readCString,
+}
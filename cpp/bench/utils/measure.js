@@ -0,0 +1,72 @@
+const R = require('ramda')
+const stages = require('./stages')
+
+const percentile = R.curry((_p, _sorted) =>
+  _sorted.length === 0
+    ? 0
+    : _sorted[Math.min(_sorted.length - 1, Math.floor(_p * _sorted.length))],
+)
+
+// Execute the given async function the specified number
+// of times and returns the wall-clock statistics in
+// microseconds.
+//
+// NOTE: vert executes the contracts in the node WASM
+// runtime, so absolute values are not comparable with
+// nodeos CPU billing, relative ones are.
+//
+// When stages are enabled (see ./stages.js) the mean time
+// of each stage is returned as well.
+const measure = async (_times, _fn) => {
+  const samples = []
+  const staged = {}
+  for (let i = 0; i < _times; i++) {
+    stages.reset()
+    const start = process.hrtime.bigint()
+    await _fn(i)
+    const end = process.hrtime.bigint()
+    samples.push(Number(end - start) / 1000)
+
+    if (stages.ENABLED) {
+      const durations = stages.durations(start, end)
+      for (const [name, elapsed] of Object.entries(durations))
+        staged[name] = (staged[name] || 0) + elapsed
+    }
+  }
+
+  const sorted = R.sort(R.subtract, samples)
+  const total = R.sum(samples)
+
+  return {
+    runs: _times,
+    mean: R.mean(samples).toFixed(2),
+    p50: percentile(0.5, sorted).toFixed(2),
+    p95: percentile(0.95, sorted).toFixed(2),
+    p99: percentile(0.99, sorted).toFixed(2),
+    ...(stages.ENABLED && {
+      stages: R.map(
+        _elapsed => ({
+          mean: (_elapsed / _times).toFixed(2),
+          share: `${((_elapsed / total) * 100).toFixed(1)}%`,
+        }),
+        staged,
+      ),
+    }),
+  }
+}
+
+// Deterministic and valid account name for the i-th element,
+// i.e. 0 => 'a', 26 => 'ba'
+const toAccountName = (_prefix, _i) =>
+  _prefix +
+  _i
+    .toString(26)
+    .split('')
+    .map(_c => String.fromCharCode(97 + parseInt(_c, 26)))
+    .join('')
+
+module.exports = {
+  measure,
+  percentile,
+  toAccountName,
+}
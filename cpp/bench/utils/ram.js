@@ -0,0 +1,72 @@
+const { hook } = require('./intrinsics')
+
+// RAM billed for the rows stored by the contracts, tracked by
+// wrapping the database intrinsics (see intrinsics.js). Rows are
+// billed as nodeos does: the packed size plus a fixed overhead
+// per object (see chain/include/eosio/chain/config.hpp).
+//
+// NOTE: the creation of a new table (scope) isn't accounted.
+const ROW_OVERHEAD = 108
+const INDEX_OVERHEAD = {
+  idx64: 128,
+  idx128: 136,
+  idx256: 152,
+  idx_double: 128,
+  idx_long_double: 136,
+}
+
+let usage = 0
+
+const add = _bytes => {
+  usage += _bytes
+}
+
+hook('db_store_i64', _store =>
+  function (...args) {
+    add(Number(args[5]) + ROW_OVERHEAD)
+    return _store.apply(this, args)
+  },
+)
+
+// A zero length read returns the row size
+hook('db_update_i64', (_update, _instance) =>
+  function (...args) {
+    add(Number(args[3]) - Number(_instance.env.db_get_i64(args[0], 0, 0)))
+    return _update.apply(this, args)
+  },
+)
+
+hook('db_remove_i64', (_remove, _instance) =>
+  function (...args) {
+    add(-Number(_instance.env.db_get_i64(args[0], 0, 0)) - ROW_OVERHEAD)
+    return _remove.apply(this, args)
+  },
+)
+
+for (const [index, overhead] of Object.entries(INDEX_OVERHEAD)) {
+  hook(`db_${index}_store`, _store =>
+    function (...args) {
+      add(overhead)
+      return _store.apply(this, args)
+    },
+  )
+
+  hook(`db_${index}_remove`, _remove =>
+    function (...args) {
+      add(-overhead)
+      return _remove.apply(this, args)
+    },
+  )
+}
+
+const reset = () => {
+  usage = 0
+}
+
+// Bytes of RAM billed since the last reset
+const get = () => usage
+
+module.exports = {
+  reset,
+  get,
+}
@@ -0,0 +1,128 @@
+const R = require('ramda')
+const { Blockchain } = require('@eosnetwork/vert')
+const { TimePoint } = require('@wharfkit/antelope')
+const { deploy } = require('../../test/utils/deploy')
+const { percentile } = require('./measure')
+const ram = require('./ram')
+
+// Replays a log of recorded actions against freshly deployed
+// contracts. The log is a JSON object like:
+//
+//    {
+//      "time": "2024-06-01T00:00:00.000",   // block time of the first action
+//      "blockInterval": 500,                // ms between two actions
+//      "accounts": ["user", ...],
+//      "contracts": { "xtkn.token": "xerc20.token", ... },
+//      "actions": [
+//        {
+//          "account": "xtkn.token",
+//          "name": "mint",
+//          "authorization": "bridge",
+//          "data": ["bridge", "user", "1.0000 XTKN", ""],
+//          "label": "mint",                 // optional, groups the stats
+//          "setup": true                    // optional, not measured
+//        },
+//        ...
+//      ]
+//    }
+//
+// where data is either positional or an object keyed by the ABI
+// fields. Block time moves deterministically, so the same log
+// always produces the same state.
+const getArgs = (_contract, _name, _data) => {
+  if (Array.isArray(_data)) return _data
+
+  const { type } = _contract.abi.actions.find(
+    _action => _action.name.toString() === _name,
+  )
+  const { fields } = _contract.abi.structs.find(
+    _struct => _struct.name.toString() === type.toString(),
+  )
+
+  return fields.map(_field => _data[_field.name.toString()])
+}
+
+const getAuthorization = _authorization =>
+  _authorization.includes('@') ? _authorization : `${_authorization}@active`
+
+const stats = _samples => {
+  const sorted = R.sort(R.subtract, _samples)
+  return {
+    mean: R.mean(_samples).toFixed(2),
+    p50: percentile(0.5, sorted).toFixed(2),
+    p95: percentile(0.95, sorted).toFixed(2),
+    p99: percentile(0.99, sorted).toFixed(2),
+  }
+}
+
+const replay = async (_log, _buildDir) => {
+  const blockchain = new Blockchain()
+  blockchain.createAccounts(..._log.accounts)
+
+  const contracts = R.mapObjIndexed(
+    (_name, _account) => deploy(blockchain, _account, `${_buildDir}/${_name}`),
+    _log.contracts,
+  )
+
+  const start = new Date(`${_log.time}Z`).getTime()
+  const flows = {}
+  let elapsed = 0
+  let measured = 0
+
+  for (const [i, entry] of _log.actions.entries()) {
+    blockchain.setTime(
+      TimePoint.fromMilliseconds(start + i * _log.blockInterval),
+    )
+
+    const contract = contracts[entry.account]
+    const args = getArgs(contract, entry.name, entry.data)
+    const action = contract.actions[entry.name](args)
+    const authorization = getAuthorization(entry.authorization)
+
+    if (entry.setup) {
+      await action.send(authorization)
+      continue
+    }
+
+    const label = entry.label || `${entry.account}::${entry.name}`
+    const flow = (flows[label] = flows[label] || {
+      samples: [],
+      ram: 0,
+      failed: 0,
+    })
+
+    ram.reset()
+    const before = process.hrtime.bigint()
+    try {
+      await action.send(authorization)
+    } catch (_err) {
+      flow.failed++
+    }
+    const sample = Number(process.hrtime.bigint() - before) / 1000
+
+    flow.samples.push(sample)
+    flow.ram += ram.get()
+    elapsed += sample
+    measured++
+  }
+
+  return {
+    actions: measured,
+    throughput: ((measured * 1e6) / elapsed).toFixed(2),
+    ram: R.sum(R.values(flows).map(R.prop('ram'))),
+    flows: R.map(
+      _flow => ({
+        runs: _flow.samples.length,
+        failed: _flow.failed,
+        ...stats(_flow.samples),
+        ram: _flow.ram,
+        'ram/run': (_flow.ram / _flow.samples.length).toFixed(2),
+      }),
+      flows,
+    ),
+  }
+}
+
+module.exports = {
+  replay,
+}
@@ -0,0 +1,304 @@
+const {
+  Chains,
+  Versions,
+  Protocols,
+  ProofcastEventAttestator,
+} = require('@pnetwork/event-attestator')
+const { toBeHex } = require('ethers')
+const {
+  no0x,
+  bytes32,
+  getSwapMemo,
+  getOperation,
+  getSymbolCodeRaw,
+  serializeOperation,
+  fromEthersPublicKey,
+} = require('../../test/utils')
+const { toAccountName } = require('./measure')
+
+// Synthetic action log (see replay.js) used when no recorded one
+// is given, it mixes local and non-local swaps (with and without
+// userdata), settlements with their mint cascades, transfers,
+// mints and limits updates on the following deployment:
+//
+//    tkn.token (eosio.token) <-> lockbox <-> xtkn.token <- adapter
+//    xevm.token <- adapter.evm (non-local, ERC20 on the EVM side)
+//
+// The actions are drawn with a seeded PRNG and the events signed
+// by a fixed key, hence the log is deterministic.
+const WEIGHTS = {
+  'swap (local)': 25,
+  'swap (non-local)': 15,
+  'swap (userdata)': 5,
+  'settle (local)': 20,
+  'settle (non-local)': 15,
+  transfer: 15,
+  mint: 4,
+  setlimits: 1,
+}
+
+const USERDATA_SIZES = [32, 256, 1024]
+
+const EOS_CHAIN_ID = Chains(Protocols.Eos).Mainnet
+const EVM_CHAIN_ID = Chains(Protocols.Evm).Mainnet
+const EVM_EMITTER =
+  '000000000000000000000000bcf063a9eb18bc3c6eb005791c61801b7cb16fe4'
+const EVM_TOPIC_ZERO =
+  '66756e6473206172652073616675207361667520736166752073616675202e2e'
+const EVM_SENDER = '0xf39fd6e51aad88f6f4ce6ab8827279cfffb92266'
+const EVM_RECIPIENT = '0x68bbed6a47194eff1cf514b50ea91895597fc91e'
+const ERC20_BYTES =
+  '000000000000000000000000810090f35dfa6b18b5eb59d298e2a2443a2811e2'
+const TEE_PRIVATE_KEY =
+  'dfcc79a57e91c42d7eea05f82a08bd1b7e77f30236bb7c56fe98d3366a1929c4'
+
+// mulberry32
+const prng = _seed => () => {
+  _seed = (_seed + 0x6d2b79f5) | 0
+  let t = Math.imul(_seed ^ (_seed >>> 15), 1 | _seed)
+  t = (t + Math.imul(t ^ (t >>> 7), 61 | t)) ^ t
+  return ((t ^ (t >>> 14)) >>> 0) / 4294967296
+}
+
+const asset = (_amount, _symbol) => `${_amount.toFixed(4)} ${_symbol}`
+
+const getSampleLog = ({ actions = 1000, seed = 1, users = 5 } = {}) => {
+  const random = prng(seed)
+  const pick = _list => _list[Math.floor(random() * _list.length)]
+  const amount = (_min, _max) => _min + Math.floor(random() * (_max - _min))
+
+  const ea = new ProofcastEventAttestator({
+    version: Versions.V1,
+    protocolId: Protocols.Evm,
+    chainId: EVM_CHAIN_ID,
+    privateKey: TEE_PRIVATE_KEY,
+  })
+
+  const accounts = [...Array(users).keys()].map(_i =>
+    toAccountName('user.', _i),
+  )
+  const log = {
+    time: '2024-06-01T00:00:00.000',
+    blockInterval: 500,
+    accounts: [...accounts, 'issuer', 'bridge', 'relayer', 'feemanager'],
+    contracts: {
+      'tkn.token': 'eosio.token',
+      'xtkn.token': 'xerc20.token',
+      'xevm.token': 'xerc20.token',
+      lockbox: 'lockbox',
+      adapter: 'adapter',
+      'adapter.evm': 'adapter',
+    },
+    actions: [],
+  }
+
+  const push = (_account, _name, _authorization, _data, _extra = {}) =>
+    log.actions.push({
+      account: _account,
+      name: _name,
+      authorization: _authorization,
+      data: _data,
+      ..._extra,
+    })
+  const setup = (..._args) => push(..._args, { setup: true })
+  const measured = (_label, ..._args) => push(..._args, { label: _label })
+
+  let nonce = 0
+  const getSettleData = (_local, _recipient, _amount) => {
+    const operation = getOperation({
+      local: _local,
+      nonce: nonce++,
+      token: _local ? '4,TKN' : ERC20_BYTES,
+      originChainId: EVM_CHAIN_ID,
+      destinationChainId: EOS_CHAIN_ID,
+      amount: _amount,
+      sender: EVM_SENDER,
+      recipient: _recipient,
+    })
+
+    const event = {
+      blockHash: operation.blockId,
+      transactionHash: operation.txId,
+      address: EVM_EMITTER,
+      topics: [EVM_TOPIC_ZERO],
+      data: serializeOperation(operation),
+    }
+
+    const metadata = {
+      preimage: ea.getEventPreImage(event),
+      signature: ea.formatEosSignature(ea.sign(event)),
+    }
+
+    return ['relayer', no0x(operation), no0x(metadata)]
+  }
+
+  const getMemo = _user =>
+    getSwapMemo(_user, bytes32(EVM_CHAIN_ID), EVM_RECIPIENT, '')
+
+  const limit = _symbol => asset(10000000, _symbol)
+
+  // Tokens
+  setup('tkn.token', 'create', 'tkn.token', ['issuer', limit('TKN')])
+  setup('xtkn.token', 'create', 'xtkn.token', ['issuer', limit('XTKN')])
+  setup('xevm.token', 'create', 'xevm.token', ['issuer', limit('XEVM')])
+  setup('lockbox', 'create', 'lockbox', [
+    'xtkn.token',
+    '4,XTKN',
+    'tkn.token',
+    '4,TKN',
+  ])
+  setup('xtkn.token', 'setlockbox', 'xtkn.token', ['lockbox'])
+  setup('xtkn.token', 'setlimits', 'xtkn.token', [
+    'adapter',
+    limit('XTKN'),
+    limit('XTKN'),
+  ])
+  for (const bridge of ['adapter.evm', 'bridge']) {
+    setup('xevm.token', 'setlimits', 'xevm.token', [
+      bridge,
+      limit('XEVM'),
+      limit('XEVM'),
+    ])
+  }
+
+  // Adapters
+  const teeKey = fromEthersPublicKey(ea.signingKey.compressedPublicKey)
+  const adapters = [
+    ['adapter', 'xtkn.token', '4,XTKN', 'tkn.token', '4,TKN'],
+    ['adapter.evm', 'xevm.token', '4,XEVM', '', '18,EVM'],
+  ]
+  for (const [adapter, xerc20, xsymbol, token, symbol] of adapters) {
+    const tokenBytes =
+      token === ''
+        ? ERC20_BYTES
+        : no0x(bytes32(toBeHex(Number(getSymbolCodeRaw(symbol)))))
+    const minFee = asset(0.0018, xsymbol.split(',')[1])
+
+    setup(adapter, 'create', adapter, [
+      xerc20,
+      xsymbol,
+      token,
+      symbol,
+      tokenBytes,
+      minFee,
+    ])
+    setup(adapter, 'setfeemanagr', adapter, ['feemanager'])
+    setup(adapter, 'setchainid', adapter, [no0x(EOS_CHAIN_ID)])
+    setup(adapter, 'settee', adapter, [teeKey, ''])
+    setup(adapter, 'setorigin', adapter, [
+      no0x(bytes32(EVM_CHAIN_ID)),
+      EVM_EMITTER,
+      EVM_TOPIC_ZERO,
+    ])
+  }
+
+  // Balances, the initial local swaps lock the
+  // collateral released by the local settlements
+  for (const user of accounts) {
+    setup('tkn.token', 'issue', 'issuer', [
+      'issuer',
+      asset(100000, 'TKN'),
+      '',
+    ])
+    setup('tkn.token', 'transfer', 'issuer', [
+      'issuer',
+      user,
+      asset(100000, 'TKN'),
+      '',
+    ])
+    setup('tkn.token', 'transfer', user, [
+      user,
+      'adapter',
+      asset(10000, 'TKN'),
+      getMemo(user),
+    ])
+    setup(
+      'adapter.evm',
+      'settle',
+      'relayer',
+      getSettleData(false, user, 10000),
+    )
+  }
+
+  const flows = {
+    'swap (local)': user =>
+      measured('swap (local)', 'tkn.token', 'transfer', user, [
+        user,
+        'adapter',
+        asset(amount(1, 20), 'TKN'),
+        getMemo(user),
+      ]),
+    'swap (non-local)': user =>
+      measured('swap (non-local)', 'xevm.token', 'transfer', user, [
+        user,
+        'adapter.evm',
+        asset(amount(1, 20), 'XEVM'),
+        getMemo(user),
+      ]),
+    'swap (userdata)': user => {
+      const size = pick(USERDATA_SIZES)
+      measured('adduserdata', 'adapter', 'adduserdata', user, [
+        user,
+        'ab'.repeat(size),
+      ])
+      measured(`swap (${size}B userdata)`, 'tkn.token', 'transfer', user, [
+        user,
+        'adapter',
+        asset(amount(1, 20), 'TKN'),
+        getSwapMemo(user, bytes32(EVM_CHAIN_ID), EVM_RECIPIENT, '1'),
+      ])
+    },
+    'settle (local)': user =>
+      measured(
+        'settle (local)',
+        'adapter',
+        'settle',
+        'relayer',
+        getSettleData(true, user, amount(1, 10)),
+      ),
+    'settle (non-local)': user =>
+      measured(
+        'settle (non-local)',
+        'adapter.evm',
+        'settle',
+        'relayer',
+        getSettleData(false, user, amount(1, 10)),
+      ),
+    transfer: user =>
+      measured('transfer', 'xevm.token', 'transfer', user, [
+        user,
+        pick(accounts.filter(_account => _account !== user)),
+        asset(amount(1, 5), 'XEVM'),
+        '',
+      ]),
+    mint: user =>
+      measured('mint', 'xevm.token', 'mint', 'bridge', [
+        'bridge',
+        user,
+        asset(amount(1, 100), 'XEVM'),
+        '',
+      ]),
+    setlimits: () =>
+      measured('setlimits', 'xevm.token', 'setlimits', 'xevm.token', [
+        'bridge',
+        limit('XEVM'),
+        limit('XEVM'),
+      ]),
+  }
+
+  const total = Object.values(WEIGHTS).reduce((_a, _b) => _a + _b, 0)
+  const draw = () => {
+    let x = random() * total
+    for (const [flow, weight] of Object.entries(WEIGHTS)) {
+      if ((x -= weight) < 0) return flow
+    }
+  }
+
+  for (let i = 0; i < actions; i++) flows[draw()](pick(accounts))
+
+  return log
+}
+
+module.exports = {
+  getSampleLog,
+}
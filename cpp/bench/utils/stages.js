@@ -0,0 +1,74 @@
+const R = require('ramda')
+const { hook, readString, readCString } = require('./intrinsics')
+
+// Per-stage breakdown of the measured flows, enabled with STAGES=1
+// (see `yarn bench:stages`) on the contracts built by `make stages`.
+//
+// Each STAGE(name) marker (see contracts/stages.hpp) prints
+// '#stage:<name>', here the print intrinsics are wrapped (see
+// intrinsics.js) so that markers are timestamped (and not
+// forwarded to the console). A marker ends the previous stage, the
+// last one lasts until the transaction resolves and the time before
+// the first one (deserialization, dispatching) goes under '(before)'.
+//
+// NOTE: vert doesn't meter the executed instructions, stages are
+// attributed the wall-clock time spent between the markers, hence
+// the same caveat of measure() applies.
+const ENABLED = process.env.STAGES === '1'
+const BUILD_DIR = ENABLED ? 'contracts/build-stages' : 'contracts/build'
+const MARKER = '#stage:'
+const BEFORE = '(before)'
+
+let marks = []
+
+const wrapPrint = _read => (_print, _instance) =>
+  function (...args) {
+    const str = _read(_instance.memory, ...args)
+    if (!str.startsWith(MARKER)) return _print.apply(this, args)
+
+    marks.push({
+      name: str.slice(MARKER.length).trim(),
+      time: process.hrtime.bigint(),
+    })
+  }
+
+if (ENABLED) {
+  hook('prints', wrapPrint(readCString))
+  hook('prints_l', wrapPrint(readString))
+}
+
+const reset = () => {
+  marks = []
+}
+
+// Durations (µs) of the stages marked between _start and _end,
+// a stage marked more than once (i.e. by inline actions) sums up
+const durations = (_start, _end) => {
+  const bounds = [{ name: BEFORE, time: _start }, ...marks]
+  return bounds.reduce((_acc, _mark, _i) => {
+    const next = _i + 1 < bounds.length ? bounds[_i + 1].time : _end
+    const elapsed = Number(next - _mark.time) / 1000
+    return R.assoc(_mark.name, (_acc[_mark.name] || 0) + elapsed, _acc)
+  }, {})
+}
+
+// Prints the measured flows and, when enabled, a stage
+// breakdown for each one of them
+const report = _results => {
+  console.table(R.map(R.omit(['stages']), _results))
+
+  if (!ENABLED) return
+
+  for (const [flow, result] of Object.entries(_results)) {
+    console.log(`\nStages of ${flow}`)
+    console.table(result.stages)
+  }
+}
+
+module.exports = {
+  ENABLED,
+  BUILD_DIR,
+  reset,
+  durations,
+  report,
+}
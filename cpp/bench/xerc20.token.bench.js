@@ -0,0 +1,86 @@
+const { Blockchain } = require('@eosnetwork/vert')
+const { Asset, TimePointSec } = require('@wharfkit/antelope')
+const { deploy } = require('../test/utils/deploy')
+const { active, precision } = require('../test/utils/eos-ext')
+const { measure, toAccountName } = require('./utils/measure')
+const { BUILD_DIR, report } = require('./utils/stages')
+
+describe('xerc20.token benchmarks', () => {
+  const RUNS = 100
+  const symbol = 'TKN'
+  const symbolPrecision = precision(4, symbol)
+  const maxSupply = Asset.from(500000000, symbolPrecision)
+  const mintingLimit = Asset.from(1000000, symbolPrecision)
+  const burningLimit = Asset.from(1000000, symbolPrecision)
+  const quantity = Asset.from(1, symbolPrecision)
+
+  const issuer = 'issuer'
+  const recipient = 'recipient'
+  const results = {}
+
+  after(() => report(results))
+
+  for (const bridgesNum of [1, 10, 500]) {
+    it(`mint with ${bridgesNum} registered bridges`, async () => {
+      const blockchain = new Blockchain()
+      const account = `${symbol.toLowerCase()}.token`
+      blockchain.createAccounts(issuer, recipient)
+      blockchain.setTime(TimePointSec.fromMilliseconds(Date.now()))
+
+      const xerc20 = deploy(blockchain, account, `${BUILD_DIR}/xerc20.token`)
+      await xerc20.actions.create([issuer, maxSupply]).send()
+
+      const bridges = [...Array(bridgesNum).keys()].map(_i =>
+        toAccountName('bridge.', _i),
+      )
+      blockchain.createAccounts(...bridges)
+
+      for (const bridge of bridges) {
+        await xerc20.actions
+          .setlimits([bridge, mintingLimit, burningLimit])
+          .send()
+      }
+
+      // The last registered one is the worst case
+      // for a linear scan over the bridges
+      const bridge = bridges[bridges.length - 1]
+
+      results[`mint (${bridgesNum} bridges)`] = await measure(RUNS, () =>
+        xerc20.actions
+          .mint([bridge, recipient, quantity, ''])
+          .send(active(bridge)),
+      )
+    })
+  }
+
+  for (const freezing of ['disabled', 'enabled']) {
+    it(`transfer with freezing ${freezing}`, async () => {
+      const blockchain = new Blockchain()
+      const account = `${symbol.toLowerCase()}.token`
+      const bridge = 'bridge'
+      const sender = 'sender'
+      const freezer = 'freezer'
+      blockchain.createAccounts(issuer, recipient, bridge, sender, freezer)
+
+      const xerc20 = deploy(blockchain, account, `${BUILD_DIR}/xerc20.token`)
+      await xerc20.actions.create([issuer, maxSupply]).send()
+      await xerc20.actions
+        .setlimits([bridge, mintingLimit, burningLimit])
+        .send()
+      await xerc20.actions
+        .mint([bridge, sender, Asset.from(1000, symbolPrecision), ''])
+        .send(active(bridge))
+
+      if (freezing === 'enabled') {
+        await xerc20.actions.setfreezeacc([freezer]).send()
+        await xerc20.actions.freeze([issuer]).send(active(freezer))
+      }
+
+      results[`transfer (freezing ${freezing})`] = await measure(RUNS, () =>
+        xerc20.actions
+          .transfer([sender, recipient, quantity, ''])
+          .send(active(sender)),
+      )
+    })
+  }
+})
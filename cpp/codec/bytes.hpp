@@ -0,0 +1,167 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace pnetwork {
+   namespace codec {
+      using bytes = std::vector<uint8_t>;
+      using bytes32 = std::array<uint8_t, 32>;
+      using uint128 = unsigned __int128;
+
+      // No exceptions on the contracts side, hence each
+      // decoding step returns one of these
+      enum class error {
+         ok,
+         truncated,
+         invalid_hex,
+         invalid_number,
+         overflow,
+         invalid_protocol,
+         invalid_recipient,
+         invalid_memo,
+      };
+
+      inline const char* get_error_message(error e) {
+         switch (e) {
+            case error::ok: return "ok";
+            case error::truncated: return "truncated data";
+            case error::invalid_hex: return "invalid hex string";
+            case error::invalid_number: return "invalid number";
+            case error::overflow: return "number overflow";
+            case error::invalid_protocol: return "invalid protocol";
+            case error::invalid_recipient: return "invalid recipient";
+            case error::invalid_memo: return "invalid memo format";
+         }
+         return "unknown error";
+      }
+
+      // Same lenient conversion of the contracts: characters
+      // outside of [0-9a-fA-F] are returned as they are
+      inline uint8_t from_hex_char(uint8_t x) {
+         if ((x >= 97) && (x <= 102)) { // [a, b, c, ..., f]
+            x -= 87;
+         } else if ((x >= 65) && (x <= 70)) { // [A, B, C, ..., F]
+            x -= 55;
+         } else if ((x >= 48) && (x <= 57)) { // [0, 1, 2, ... ,9]
+            x -= 48;
+         }
+
+         return x;
+      }
+
+      // Decodes the hex characters pairwise, size must be even
+      inline bytes decode_hex(const uint8_t* data, size_t size) {
+         bytes x(size / 2, 0);
+         for (size_t i = 0, k = 0; i + 1 < size; i += 2) {
+            x[k++] = from_hex_char(data[i]) * 16 + from_hex_char(data[i + 1]);
+         }
+
+         return x;
+      }
+
+      inline bool is_hex_char(char c) {
+         return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+      }
+
+      // Strict version of the above for untrusted input,
+      // an optional 0x prefix is accepted
+      inline error from_hex(const std::string& hex, bytes& out) {
+         size_t start = hex.compare(0, 2, "0x") == 0 ? 2 : 0;
+         if ((hex.size() - start) % 2 != 0) return error::invalid_hex;
+
+         for (size_t i = start; i < hex.size(); i++) {
+            if (!is_hex_char(hex[i])) return error::invalid_hex;
+         }
+
+         out = decode_hex(reinterpret_cast<const uint8_t*>(hex.data()) + start, hex.size() - start);
+         return error::ok;
+      }
+
+      inline std::string to_hex(const uint8_t* data, size_t size) {
+         static const char digits[] = "0123456789abcdef";
+         std::string hex(size * 2, '0');
+         for (size_t i = 0; i < size; i++) {
+            hex[2 * i] = digits[data[i] >> 4];
+            hex[2 * i + 1] = digits[data[i] & 0x0f];
+         }
+
+         return hex;
+      }
+
+      template<typename T>
+      std::string to_hex(const T& data) {
+         return to_hex(data.data(), data.size());
+      }
+
+      inline bytes32 read_bytes32(const uint8_t* data) {
+         bytes32 value;
+         std::copy(data, data + 32, value.begin());
+         return value;
+      }
+
+      // Big endian, left padded with zeros
+      inline bytes32 to_bytes32(uint128 value) {
+         bytes32 vec{};
+         for (size_t i = 0; i < 16; i++) {
+            vec[31 - i] = static_cast<uint8_t>(value >> (i * 8));
+         }
+
+         return vec;
+      }
+
+      // Ascii characters right aligned, as the contracts
+      // encode account names, i.e. "TKN" => 0x00..004e4b54
+      inline bytes32 to_bytes32(const std::string& value) {
+         bytes32 vec{};
+         size_t size = std::min(value.size(), vec.size());
+         std::copy(value.end() - size, value.end(), vec.end() - size);
+         return vec;
+      }
+
+      // Numbers not fitting the given width are rejected
+      template<typename T>
+      error from_bytes32(const bytes32& data, T& out) {
+         for (size_t i = 0; i < 32 - sizeof(T); i++) {
+            if (data[i] != 0) return error::overflow;
+         }
+
+         out = 0;
+         for (size_t i = 32 - sizeof(T); i < 32; i++) {
+            out = (out << 8) | data[i];
+         }
+
+         return error::ok;
+      }
+
+      inline std::string to_string(uint128 value) {
+         if (value == 0) return "0";
+
+         std::string str;
+         for (; value > 0; value /= 10) {
+            str.insert(str.begin(), static_cast<char>('0' + static_cast<int>(value % 10)));
+         }
+
+         return str;
+      }
+
+      inline error from_string(const std::string& str, uint128& out) {
+         if (str.empty()) return error::invalid_number;
+
+         const uint128 max = ~static_cast<uint128>(0);
+         out = 0;
+         for (char c : str) {
+            if (c < '0' || c > '9') return error::invalid_number;
+            uint8_t digit = c - '0';
+            if (out > (max - digit) / 10) return error::overflow;
+            out = out * 10 + digit;
+         }
+
+         return error::ok;
+      }
+   }
+}
@@ -0,0 +1,225 @@
+// Batch encoder/decoder of the pNetwork event formats, one item
+// per line from the given files (or stdin), one result per line
+// on stdout. Errors are reported on stderr with the line number.
+//
+// Usage: pnetwork-codec <command> [file...]
+//
+//    preimage       hex preimage => JSON of the parsed fields
+//    event-id       hex preimage => hex event id
+//    operation      hex preimage => JSON settle operation
+//    decode-event   hex event bytes => JSON swap event
+//    encode-event   "nonce token destChainId amount sender recipient [data]" => hex event bytes
+//    decode-memo    swap memo => JSON of its fields
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <functional>
+
+#include "codec.hpp"
+
+using namespace pnetwork::codec;
+using handler = std::function<error(const std::string&, std::string&)>;
+
+namespace {
+   // Recipients are not validated by decode-event,
+   // hence strings are escaped
+   std::string quote(const std::string& str) {
+      std::ostringstream out;
+      out << '"';
+      for (unsigned char c : str) {
+         if (c == '"' || c == '\\') out << '\\' << c;
+         else if (c < 0x20) out << "\\u00" << to_hex(&c, 1);
+         else out << c;
+      }
+      out << '"';
+      return out.str();
+   }
+
+   std::string hex(const bytes32& value) {
+      return quote(to_hex(value));
+   }
+
+   error parse_bytes32(const std::string& str, bytes32& out) {
+      bytes data;
+      error e = from_hex(str, data);
+      if (e != error::ok) return e;
+      if (data.size() != 32) return error::invalid_hex;
+
+      std::copy(data.begin(), data.end(), out.begin());
+      return error::ok;
+   }
+
+   error cmd_preimage(const std::string& line, std::string& out) {
+      bytes data;
+      preimage p;
+      error e = from_hex(line, data);
+      if (e == error::ok) e = parse_preimage(data, p);
+      if (e != error::ok) return e;
+
+      std::ostringstream json;
+      json << "{\"version\":" << int(p.version)
+         << ",\"protocol\":" << int(p.protocol)
+         << ",\"originChainId\":" << hex(p.origin_chain_id)
+         << ",\"blockId\":" << hex(p.block_id)
+         << ",\"txId\":" << hex(p.tx_id)
+         << ",\"emitter\":" << hex(p.emitter)
+         << ",\"topics\":[" << hex(p.topics[0]) << "," << hex(p.topics[1]) << ","
+         << hex(p.topics[2]) << "," << hex(p.topics[3]) << "]"
+         << ",\"eventId\":" << hex(get_event_id(data))
+         << ",\"eventData\":" << quote(to_hex(p.event_data)) << "}";
+      out = json.str();
+      return error::ok;
+   }
+
+   error cmd_event_id(const std::string& line, std::string& out) {
+      bytes data;
+      error e = from_hex(line, data);
+      if (e != error::ok) return e;
+
+      out = to_hex(get_event_id(data));
+      return error::ok;
+   }
+
+   error cmd_operation(const std::string& line, std::string& out) {
+      bytes data;
+      preimage p;
+      operation op;
+      error e = from_hex(line, data);
+      if (e == error::ok) e = parse_preimage(data, p);
+      if (e == error::ok) e = build_operation(p, op);
+      if (e != error::ok) return e;
+
+      // Same field names of the ABI, so that it can be
+      // passed as it is to the settle action
+      std::ostringstream json;
+      json << "{\"blockId\":" << hex(op.block_id)
+         << ",\"txId\":" << hex(op.tx_id)
+         << ",\"nonce\":" << op.nonce
+         << ",\"token\":" << hex(op.token)
+         << ",\"originChainId\":" << hex(op.origin_chain_id)
+         << ",\"destinationChainId\":" << hex(op.destination_chain_id)
+         << ",\"amount\":" << quote(to_string(op.amount))
+         << ",\"sender\":" << hex(op.sender)
+         << ",\"recipient\":" << quote(op.recipient)
+         << ",\"data\":" << quote(to_hex(op.data)) << "}";
+      out = json.str();
+      return error::ok;
+   }
+
+   error cmd_decode_event(const std::string& line, std::string& out) {
+      bytes data;
+      swap_event event;
+      error e = from_hex(line, data);
+      if (e == error::ok) e = decode_swap_event(data, event);
+      if (e != error::ok) return e;
+
+      std::ostringstream json;
+      json << "{\"nonce\":" << event.nonce
+         << ",\"token\":" << hex(event.token)
+         << ",\"destinationChainId\":" << hex(event.destination_chain_id)
+         << ",\"amount\":" << quote(to_string(event.amount))
+         << ",\"sender\":" << hex(event.sender)
+         << ",\"recipient\":" << quote(event.recipient)
+         << ",\"data\":" << quote(to_hex(event.data)) << "}";
+      out = json.str();
+      return error::ok;
+   }
+
+   error cmd_encode_event(const std::string& line, std::string& out) {
+      std::istringstream fields(line);
+      std::string nonce, token, dest_chain_id, amount, sender, recipient, data;
+      if (!(fields >> nonce >> token >> dest_chain_id >> amount >> sender >> recipient)) return error::truncated;
+      fields >> data;
+
+      swap_event event;
+      uint128 nonce_num = 0;
+      error e = from_string(nonce, nonce_num);
+      if (e == error::ok && nonce_num > UINT64_MAX) e = error::overflow;
+      if (e == error::ok) e = parse_bytes32(token, event.token);
+      if (e == error::ok) e = parse_bytes32(dest_chain_id, event.destination_chain_id);
+      if (e == error::ok) e = from_string(amount, event.amount);
+      if (e == error::ok) e = parse_bytes32(sender, event.sender);
+      if (e == error::ok) e = from_hex(data, event.data);
+      if (e != error::ok) return e;
+
+      event.nonce = static_cast<uint64_t>(nonce_num);
+      event.recipient = recipient;
+      out = to_hex(encode_swap_event(event));
+      return error::ok;
+   }
+
+   error cmd_decode_memo(const std::string& line, std::string& out) {
+      swap_memo memo;
+      error e = parse_swap_memo(line, memo);
+      if (e != error::ok) return e;
+
+      std::ostringstream json;
+      json << "{\"sender\":" << quote(memo.sender)
+         << ",\"destinationChainId\":" << quote(memo.destination_chain_id)
+         << ",\"recipient\":" << quote(memo.recipient)
+         << ",\"hasUserdata\":" << (memo.has_userdata ? "true" : "false") << "}";
+      out = json.str();
+      return error::ok;
+   }
+
+   bool run(const handler& fn, std::istream& in, const std::string& source) {
+      bool ok = true;
+      std::string line, out;
+      for (size_t n = 1; std::getline(in, line); n++) {
+         if (!line.empty() && line.back() == '\r') line.pop_back();
+         if (line.empty()) continue;
+
+         error e = fn(line, out);
+         if (e != error::ok) {
+            std::cerr << source << ":" << n << ": " << get_error_message(e) << "\n";
+            ok = false;
+            continue;
+         }
+
+         std::cout << out << "\n";
+      }
+
+      return ok;
+   }
+
+   int usage() {
+      std::cerr << "Usage: pnetwork-codec <preimage|event-id|operation|decode-event|encode-event|decode-memo> [file...]\n";
+      return 2;
+   }
+}
+
+int main(int argc, char** argv) {
+   std::ios::sync_with_stdio(false);
+   if (argc < 2) return usage();
+
+   const std::string command = argv[1];
+   handler fn;
+   if (command == "preimage") fn = cmd_preimage;
+   else if (command == "event-id") fn = cmd_event_id;
+   else if (command == "operation") fn = cmd_operation;
+   else if (command == "decode-event") fn = cmd_decode_event;
+   else if (command == "encode-event") fn = cmd_encode_event;
+   else if (command == "decode-memo") fn = cmd_decode_memo;
+   else return usage();
+
+   bool ok = true;
+   if (argc == 2) ok = run(fn, std::cin, "stdin");
+
+   for (int i = 2; i < argc; i++) {
+      const std::string path = argv[i];
+      if (path == "-") {
+         ok = run(fn, std::cin, "stdin") && ok;
+         continue;
+      }
+
+      std::ifstream file(path);
+      if (!file) {
+         std::cerr << path << ": cannot open file\n";
+         ok = false;
+         continue;
+      }
+      ok = run(fn, file, path) && ok;
+   }
+
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+// Header only codec of the pNetwork event formats, free of eosio
+// dependencies so that relayers and tools can share it with the
+// contracts (see README.md)
+#include "bytes.hpp"
+#include "sha256.hpp"
+#include "preimage.hpp"
+#include "swap_event.hpp"
+#include "operation.hpp"
+#include "memo.hpp"
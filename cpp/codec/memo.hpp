@@ -0,0 +1,70 @@
+#pragma once
+
+#include "bytes.hpp"
+
+namespace pnetwork {
+   namespace codec {
+      // Memo of the transfers swapped by the adapter:
+      //
+      //    '<sender>,<0x destination chain id>,<recipient>,<has userdata>'
+      //
+      // Empty fields are skipped as the split of the contracts did,
+      // i.e. 'user,,0x01,0xabc,0' is the same of 'user,0x01,0xabc,0'.
+      struct swap_memo {
+         std::string sender;
+         std::string destination_chain_id;
+         std::string recipient;
+         bool has_userdata = false;
+      };
+
+      constexpr size_t SWAP_MEMO_FIELDS = 4;
+
+      // Single pass, without allocating the fields, and stopping at the
+      // first field in excess so that malformed memos fail early
+      inline error parse_swap_memo(const std::string& memo, swap_memo& out) {
+         std::string* fields[SWAP_MEMO_FIELDS] = { &out.sender, &out.destination_chain_id, &out.recipient, nullptr };
+         size_t begin[SWAP_MEMO_FIELDS] = {};
+         size_t end[SWAP_MEMO_FIELDS] = {};
+         size_t count = 0;
+
+         for (size_t pos = 0; pos < memo.size();) {
+            size_t next = memo.find(',', pos);
+            if (next == std::string::npos) next = memo.size();
+
+            if (next > pos) {
+               if (count == SWAP_MEMO_FIELDS) return error::invalid_memo;
+               begin[count] = pos;
+               end[count] = next;
+               count++;
+            }
+            pos = next + 1;
+         }
+
+         if (count != SWAP_MEMO_FIELDS) return error::invalid_memo;
+
+         for (size_t i = 0; i < SWAP_MEMO_FIELDS - 1; i++) {
+            fields[i]->assign(memo, begin[i], end[i] - begin[i]);
+         }
+
+         // Userdata flag, parsed as the contracts did before the codec,
+         // i.e. std::stoi truncated to uint8_t: leading spaces and a sign
+         // are allowed, trailing characters ignored, "256" is false and
+         // "-1" is true, values out of the int range are rejected
+         auto is_digit = [&](size_t i) { return memo[i] >= '0' && memo[i] <= '9'; };
+         size_t i = begin[3];
+         while (i < end[3] && (memo[i] == ' ' || (memo[i] >= '\t' && memo[i] <= '\r'))) i++;
+         bool negative = i < end[3] && memo[i] == '-';
+         if (i < end[3] && (memo[i] == '-' || memo[i] == '+')) i++;
+         if (i == end[3] || !is_digit(i)) return error::invalid_memo;
+
+         int64_t value = 0;
+         for (; i < end[3] && is_digit(i); i++) {
+            value = value * 10 + (memo[i] - '0');
+            if (value > (negative ? 2147483648LL : 2147483647LL)) return error::invalid_memo;
+         }
+         out.has_userdata = static_cast<uint8_t>(negative ? -value : value) != 0;
+
+         return error::ok;
+      }
+   }
+}
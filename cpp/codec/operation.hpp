@@ -0,0 +1,60 @@
+#pragma once
+
+#include "bytes.hpp"
+#include "preimage.hpp"
+#include "swap_event.hpp"
+
+namespace pnetwork {
+   namespace codec {
+      // Mirrors eosio::operation (see contracts/operation.hpp),
+      // the argument of the adapter settle action
+      struct operation {
+         bytes32 block_id{};
+         bytes32 tx_id{};
+         uint64_t nonce = 0;
+         bytes32 token{};
+         bytes32 origin_chain_id{};
+         bytes32 destination_chain_id{};
+         uint128 amount = 0;
+         bytes32 sender{};
+         std::string recipient;
+         bytes data;
+      };
+
+      // Same rules of the eosio::name string constructor, except for
+      // the empty name which is never an account (see pam::authorize)
+      inline bool is_valid_name(const std::string& str) {
+         if (str.empty() || str.size() > 13) return false;
+
+         for (size_t i = 0; i < str.size(); i++) {
+            char c = str[i];
+            bool valid = c == '.' || (c >= '1' && c <= '5') || (c >= 'a' && c <= 'z');
+            if (!valid || (i == 12 && c > 'j')) return false;
+         }
+
+         return true;
+      }
+
+      // Derives the operation from an attested preimage, as
+      // settle2 does on chain (see pam::check_authorization)
+      inline error build_operation(const preimage& preimage, operation& out) {
+         swap_event event;
+         error e = decode_swap_event(preimage.event_data, event);
+         if (e != error::ok) return e;
+         if (!is_valid_name(event.recipient)) return error::invalid_recipient;
+
+         out.block_id = preimage.block_id;
+         out.tx_id = preimage.tx_id;
+         out.nonce = event.nonce;
+         out.token = event.token;
+         out.origin_chain_id = preimage.origin_chain_id;
+         out.destination_chain_id = event.destination_chain_id;
+         out.amount = event.amount;
+         out.sender = event.sender;
+         out.recipient = event.recipient;
+         out.data = event.data;
+
+         return error::ok;
+      }
+   }
+}
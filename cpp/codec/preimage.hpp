@@ -0,0 +1,87 @@
+#pragma once
+
+#include "bytes.hpp"
+#include "sha256.hpp"
+
+namespace pnetwork {
+   namespace codec {
+      // Protocol ids (see event-attestator/src/Protocols.js)
+      constexpr uint8_t PROTOCOL_EVM = 0x01;
+      constexpr uint8_t PROTOCOL_EOS = 0x02; // event bytes as hex JSON string
+      constexpr uint8_t PROTOCOL_EOS_BINARY = 0x04; // raw event bytes
+
+      // Metadata preimage format:
+      //    | version | protocol | origin | blockHash | txHash | eventPayload |
+      //    |   1B    |    1B    |   32B  |    32B    |   32B  |    varlen    |
+      //    +----------- context ---------+------------- event ---------------+
+      //
+      // Event payload format
+      // |  emitter  |    topic-0     |    topics-1     |    topics-2     |    topics-3     |  eventBytes  |
+      // |    32B    |      32B       |       32B       |       32B       |       32B       |    varlen    |
+      constexpr size_t VERSION_OFFSET = 0;
+      constexpr size_t PROTOCOL_OFFSET = 1;
+      constexpr size_t ORIGIN_CHAIN_ID_OFFSET = 2;
+      constexpr size_t BLOCK_ID_OFFSET = 34;
+      constexpr size_t TX_ID_OFFSET = 66;
+      constexpr size_t EVENT_PAYLOAD_OFFSET = 98;
+      constexpr size_t EVENT_DATA_OFFSET = EVENT_PAYLOAD_OFFSET + 32 * 5;
+
+      // EOS events attested with PROTOCOL_EOS carry the event bytes
+      // as '{"event_bytes":"<hex>"}', these are the chars around them
+      constexpr size_t EOS_JSON_PREFIX_SIZE = 16;
+      constexpr size_t EOS_JSON_SUFFIX_SIZE = 2;
+
+      struct preimage {
+         uint8_t version = 0;
+         uint8_t protocol = 0;
+         bytes32 origin_chain_id{};
+         bytes32 block_id{};
+         bytes32 tx_id{};
+         bytes32 emitter{};
+         std::array<bytes32, 4> topics{};
+         bytes event_data;
+      };
+
+      // Event data as the adapter reads it: decoded from the JSON
+      // string for PROTOCOL_EOS, as it is for any other protocol
+      inline error decode_event_data(uint8_t protocol, const uint8_t* data, size_t size, bytes& out) {
+         if (protocol != PROTOCOL_EOS) {
+            out.assign(data, data + size);
+            return error::ok;
+         }
+
+         if (size < EOS_JSON_PREFIX_SIZE + EOS_JSON_SUFFIX_SIZE) return error::truncated;
+         size_t hex_size = size - EOS_JSON_PREFIX_SIZE - EOS_JSON_SUFFIX_SIZE;
+         if (hex_size % 2 != 0) return error::invalid_hex;
+
+         out = decode_hex(data + EOS_JSON_PREFIX_SIZE, hex_size);
+         return error::ok;
+      }
+
+      inline error parse_preimage(const uint8_t* data, size_t size, preimage& out) {
+         if (size < EVENT_DATA_OFFSET) return error::truncated;
+
+         out.version = data[VERSION_OFFSET];
+         out.protocol = data[PROTOCOL_OFFSET];
+         out.origin_chain_id = read_bytes32(data + ORIGIN_CHAIN_ID_OFFSET);
+         out.block_id = read_bytes32(data + BLOCK_ID_OFFSET);
+         out.tx_id = read_bytes32(data + TX_ID_OFFSET);
+         out.emitter = read_bytes32(data + EVENT_PAYLOAD_OFFSET);
+         for (size_t i = 0; i < out.topics.size(); i++) {
+            out.topics[i] = read_bytes32(data + EVENT_PAYLOAD_OFFSET + 32 * (i + 1));
+         }
+
+         return decode_event_data(out.protocol, data + EVENT_DATA_OFFSET, size - EVENT_DATA_OFFSET, out.event_data);
+      }
+
+      inline error parse_preimage(const bytes& data, preimage& out) {
+         return parse_preimage(data.data(), data.size(), out);
+      }
+
+      // The event id is the hash of the whole preimage, the
+      // one signed by the TEE and stored by the adapter
+      inline bytes32 get_event_id(const bytes& preimage) {
+         return hash_sha256(preimage.data(), preimage.size());
+      }
+   }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "bytes.hpp"
+
+namespace pnetwork {
+   namespace codec {
+      // Event bytes of the adapter swap, also the event data
+      // settled on the destination chain:
+      //
+      // | nonce | token | destChainId | amount | sender | recipientLen | recipient | data |
+      // |  32B  |  32B  |     32B     |  32B   |  32B   |     32B      |  varlen   | varlen |
+      struct swap_event {
+         uint64_t nonce = 0;
+         bytes32 token{};
+         bytes32 destination_chain_id{};
+         uint128 amount = 0; // 18 decimals
+         bytes32 sender{};
+         std::string recipient;
+         bytes data;
+      };
+
+      constexpr size_t SWAP_EVENT_HEADER_SIZE = 32 * 6;
+
+      inline bytes encode_swap_event(const swap_event& event) {
+         bytes out;
+         out.reserve(SWAP_EVENT_HEADER_SIZE + event.recipient.size() + event.data.size());
+
+         auto append = [&](const bytes32& field) { out.insert(out.end(), field.begin(), field.end()); };
+         append(to_bytes32(static_cast<uint128>(event.nonce)));
+         append(event.token);
+         append(event.destination_chain_id);
+         append(to_bytes32(event.amount));
+         append(event.sender);
+         append(to_bytes32(static_cast<uint128>(event.recipient.size())));
+         out.insert(out.end(), event.recipient.begin(), event.recipient.end());
+         out.insert(out.end(), event.data.begin(), event.data.end());
+
+         return out;
+      }
+
+      inline error decode_swap_event(const uint8_t* data, size_t size, swap_event& out) {
+         // The contracts read the recipient length as 32 bytes out of a
+         // longer buffer (see extract_32bytes), hence strictly greater
+         if (size <= SWAP_EVENT_HEADER_SIZE) return error::truncated;
+
+         error e = from_bytes32(read_bytes32(data), out.nonce);
+         if (e != error::ok) return e;
+
+         out.token = read_bytes32(data + 32);
+         out.destination_chain_id = read_bytes32(data + 64);
+
+         e = from_bytes32(read_bytes32(data + 96), out.amount);
+         if (e != error::ok) return e;
+
+         out.sender = read_bytes32(data + 128);
+
+         // A length wider than 64 bits is beyond the data as well, so
+         // truncated past the header always means a bad recipient length
+         uint64_t recipient_len = 0;
+         e = from_bytes32(read_bytes32(data + 160), recipient_len);
+         if (e != error::ok || recipient_len > size - SWAP_EVENT_HEADER_SIZE) return error::truncated;
+
+         const uint8_t* recipient = data + SWAP_EVENT_HEADER_SIZE;
+         out.recipient.assign(recipient, recipient + recipient_len);
+         out.data.assign(recipient + recipient_len, data + size);
+
+         return error::ok;
+      }
+
+      inline error decode_swap_event(const bytes& data, swap_event& out) {
+         return decode_swap_event(data.data(), data.size(), out);
+      }
+   }
+}
@@ -83,6 +83,55 @@ void adapter::setfeemanagr(const name& fee_manager) {
    _storage.set(storage, get_self());
 }
 
+void adapter::setmetrics(bool enabled) {
+   require_auth(get_self());
+   storage _storage(get_self(), get_self().value);
+
+   check(_storage.exists(), "adapter contract not initialized");
+   auto storage = _storage.get();
+
+   if (enabled && !storage.metrics.has_value()) {
+      storage.metrics.emplace();
+   } else if (!enabled) {
+      storage.metrics.reset();
+   }
+
+   _storage.set(storage, get_self());
+}
+
+void adapter::update_metrics(
+   global_storage_table& storage,
+   uint8_t direction,
+   const checksum256& chain_id,
+   const asset& volume,
+   const asset& fees,
+   uint64_t nonce
+) {
+   if (!storage.metrics.has_value()) return;
+
+   auto& metrics = storage.metrics.value();
+   auto itr = std::find_if(metrics.begin(), metrics.end(), [&](const auto& m) {
+      return m.direction == direction && m.chain_id == chain_id;
+   });
+
+   if (itr == metrics.end()) {
+      metrics.push_back(chain_metrics {
+         .direction = direction,
+         .chain_id = chain_id,
+         .count = 0,
+         .volume = 0,
+         .fees = 0,
+         .last_nonce = 0
+      });
+      itr = metrics.end() - 1;
+   }
+
+   itr->count++;
+   itr->volume += volume.amount;
+   itr->fees += fees.amount;
+   itr->last_nonce = nonce;
+}
+
 void adapter::extract_memo_args(
    const name& self,
    const string& memo,
@@ -91,16 +140,14 @@ void adapter::extract_memo_args(
    string& out_recipient,
    bytes& out_data
 ) {
+   // NOTE: shared with the off-chain tools (see codec/memo.hpp)
+   pnetwork::codec::swap_memo args;
+   check(pnetwork::codec::parse_swap_memo(memo, args) == pnetwork::codec::error::ok, "invalid memo format");
+   check(is_hex_notation(args.destination_chain_id), "chain id must be 0x prefixed");
 
-   const vector<string> parts = split(memo, ",");
-
-   check(parts.size() == 4, "invalid memo format");
-   check(is_hex_notation(parts[1]), "chain id must be 0x prefixed");
-
-   out_sender = parts[0];
-   out_dest_chainid = parts[1].substr(2);
-   out_recipient = parts[2];
-   uint8_t has_userdata = stoi(parts[3]);
+   out_sender = args.sender;
+   out_dest_chainid = args.destination_chain_id.substr(2);
+   out_recipient = args.recipient;
 
    check(out_sender.length() > 0, "invalid sender address");
    check(out_recipient.length() > 0, "invalid destination address");
@@ -109,7 +156,7 @@ void adapter::extract_memo_args(
    auto sender_account = name(out_sender);
    check(is_account(sender_account), "invalid sender account");
 
-   if (has_userdata > 0) {
+   if (args.has_userdata) {
       user_data table(self, sender_account.value);
 
       check(table.begin() != table.end(), "userdata record not found");
@@ -157,112 +204,119 @@ void adapter::freeuserdata(const name& account) {
 
 void adapter::setchainid(bytes chain_id) {
    require_auth(get_self());
-   pam::chain_id _chain_id(get_self(), get_self().value);
-   
-   _chain_id.set(pam::local_chain_id{
-      .chain_id = chain_id
-   }, get_self());
+   pam::set_local_chain_id(get_self(), chain_id);
+}
+
+// Moves the PAM settings stored with the variable length
+// layout (v1) to the fixed width tables, see migration.hpp
+migration::cursor adapter::migrate(uint32_t max_rows) {
+   require_auth(get_self());
+
+   return migration::run(get_self(), max_rows,
+      // chainid -> chainid2
+      [&](uint32_t) -> uint32_t {
+         pam::chain_id_v1 _chain_id_v1(get_self(), get_self().value);
+         if (!_chain_id_v1.exists()) return 0;
+
+         // A value set through setchainid in the meantime wins
+         pam::chain_id _chain_id(get_self(), get_self().value);
+         if (!_chain_id.exists()) {
+            _chain_id.set(pam::local_chain_id{
+               .chain_id = bytes32_to_checksum256(_chain_id_v1.get().chain_id)
+            }, get_self());
+         }
+         _chain_id_v1.remove();
+
+         return 1;
+      },
+      // mappings -> mappings2
+      [&](uint32_t budget) {
+         pam::mappings_table_v1 _mappings_table_v1(get_self(), get_self().value);
+         pam::mappings_table _mappings_table(get_self(), get_self().value);
+         return migration::drain(_mappings_table_v1, budget, [&](const auto& legacy) {
+            // Same as above for setorigin
+            if (_mappings_table.find(legacy.primary_key()) != _mappings_table.end()) return;
+
+            _mappings_table.emplace(get_self(), [&](auto& row) {
+               row = pam::from_legacy_mappings(legacy);
+            });
+         });
+      }
+   );
 }
 
 void adapter::settee(public_key pub_key, bytes attestation) {
    require_auth(get_self());
-   pam::tee_pubkey _tee_pubkey(get_self(), get_self().value);
-
-   if (!_tee_pubkey.exists()) {
-      _tee_pubkey.set(pam::tee{
-         .key = pub_key,
-         .updating_key = public_key(),
-         .attestation = attestation,
-         .updating_attestation = {},
-         .change_grace_threshold = 0
-      }, get_self());
-   } else  {
-      pam::tee tee_data = _tee_pubkey.get();
-      // Start grace period for the new TEE address
-      uint64_t current_time = eosio::current_time_point().sec_since_epoch();
-      _tee_pubkey.set(pam::tee{
-         .key = tee_data.key,
-         .attestation = tee_data.attestation,
-         .updating_key = pub_key,
-         .updating_attestation = attestation,
-         .change_grace_threshold = current_time + pam::TEE_ADDRESS_CHANGE_GRACE_PERIOD
-      }, get_self());
-   }
+   pam::set_tee(get_self(), pub_key, attestation);
 }
 
 void adapter::applynewtee() {
    require_auth(get_self());
-   pam::tee_pubkey _tee_pubkey(get_self(), get_self().value);
-   check(_tee_pubkey.exists(), "tee not set, use settee");
-   uint64_t current_time = eosio::current_time_point().sec_since_epoch();
-   pam::tee tee_data = _tee_pubkey.get();
-   if (current_time >= tee_data.change_grace_threshold) {
-      _tee_pubkey.set(pam::tee{
-         .key = tee_data.updating_key,
-         .attestation = tee_data.updating_attestation,
-         .updating_key = public_key(),
-         .updating_attestation = {},
-         .change_grace_threshold = 0
-      }, get_self());
-   } else check(false, "grace period not elapsed");
-
+   pam::apply_new_tee(get_self());
 }
 
 void adapter::setorigin(bytes chain_id, bytes emitter, bytes topic_zero) {
    require_auth(get_self());
-   check(chain_id.size() == 32, "expected 32 bytes chain_id");
-
-   check(emitter.size() == 32, "expected 32 bytes emitter");
-   check(topic_zero.size() == 32, "expected 32 bytes topic zero");
+   pam::set_origin(get_self(), chain_id, emitter, topic_zero);
+}
 
-   pam::mappings_table _mappings_table(get_self(), get_self().value);
+// Reads the PAM settings from the given registry (see pam.registry.hpp)
+// instead of the adapter's own tables, an empty name switches back
+void adapter::setregistry(const name& registry) {
+   require_auth(get_self());
+   pam::registry _registry(get_self(), get_self().value);
 
-   auto mappings_itr = _mappings_table.find(get_mappings_key(chain_id));
-   if (mappings_itr == _mappings_table.end()) {
-      _mappings_table.emplace(get_self(), [&](auto& row) {
-         row.chain_id = chain_id;
-         row.emitter = emitter;
-         row.topic_zero = topic_zero;
-      });
-   } else {
-      _mappings_table.modify(mappings_itr, get_self(), [&](auto& row) {
-         row.emitter = emitter;
-         row.topic_zero = topic_zero;
-      });
+   if (registry == name()) {
+      _registry.remove();
+      return;
    }
-}
 
-void adapter::settle(const name& caller, const operation& operation, const metadata& metadata) {
-   require_auth(caller);
-
-   registry_adapter _registry(get_self(), get_self().value);
-   check(_registry.exists(), "contract not inizialized");
-   auto registry_data = _registry.get();
-   check(registry_data.token_bytes == operation.token, "underlying token does not match with adapter registry");
-   checksum256 event_id; // output
-   pam::check_authorization(get_self(), operation, metadata, event_id);
+   check(is_account(registry), "registry must be a valid account");
+   _registry.set(registry, get_self());
+}
 
+asset adapter::settle_operation(
+   const name& caller,
+   const adapter_registry_table& registry_data,
+   const operation2& operation,
+   const checksum256& event_id
+) {
+   STAGE("settle.pastevents");
    past_events _past_events(get_self(), get_self().value);
    auto idx_past_events = _past_events.get_index<adapter_registry_idx_eventid>();
    auto itr = idx_past_events.find(event_id);
 
    check(itr == idx_past_events.end(), "event already processed");
 
+   STAGE("settle.storage");
    storage _storage(get_self(), get_self().value);
    check(_storage.exists(), "contract not initialized");
    auto storage = _storage.get();
 
+   asset quantity = adjust_precision(operation.amount, registry_data.xerc20_symbol);
+
    _past_events.emplace(caller, [&](auto& r) {
       r.notused = storage.nonce;
       r.event_id = event_id;
    });
    storage.nonce++;
+   // Same as swap, the arguments aren't built when disabled
+   if (storage.metrics.has_value()) {
+      update_metrics(
+         storage,
+         METRICS_DIRECTION_SETTLE,
+         operation.originChainId,
+         quantity,
+         asset(0, quantity.symbol),
+         operation.nonce
+      );
+   }
    _storage.set(storage, get_self());
 
+   STAGE("settle.mint");
    name xerc20 = registry_data.xerc20;
    check(is_account(xerc20), "Not valid xerc20 name");
    if (operation.amount > 0) {
-      asset quantity = adjust_precision(operation.amount, registry_data.xerc20_symbol);
       lockbox_singleton _lockbox(xerc20, xerc20.value);
       action_mint _mint(registry_data.xerc20, {get_self(), "active"_n});
       if (_lockbox.exists()) {
@@ -285,9 +339,55 @@ void adapter::settle(const name& caller, const operation& operation, const metad
    if (operation.data.size() > 0) {
       require_recipient(operation.recipient);
    }
+
+   return quantity;
+}
+
+settle_result adapter::settle(const name& caller, const operation& operation, const metadata& metadata) {
+   require_auth(caller);
+
+   STAGE("settle.registry");
+   registry_adapter _registry(get_self(), get_self().value);
+   check(_registry.exists(), "contract not inizialized");
+   auto registry_data = _registry.get();
+   check(registry_data.token_bytes == operation.token, "underlying token does not match with adapter registry");
+   checksum256 event_id; // output
+   pam::check_authorization(get_self(), operation, metadata, event_id);
+
+   asset quantity = settle_operation(caller, registry_data, to_operation2(operation), event_id);
+
+   return settle_result {
+      .event_id = event_id,
+      .quantity = quantity
+   };
+}
+
+settle_result adapter::settle2(const name& caller, const metadata& metadata) {
+   require_auth(caller);
+
+   STAGE("settle.registry");
+   registry_adapter _registry(get_self(), get_self().value);
+   check(_registry.exists(), "contract not inizialized");
+   auto registry_data = _registry.get();
+
+   // NOTE: the operation is derived from the preimage, so the
+   // relayer doesn't need to send each field twice. Receivers
+   // are notified with the metadata only, the user data can be
+   // found at the end of the preimage's event payload.
+   eosio::operation2 operation; // output
+   checksum256 event_id; // output
+   pam::check_authorization(get_self(), metadata, operation, event_id);
+   check(registry_data.token_bytes == operation.token, "underlying token does not match with adapter registry");
+
+   asset quantity = settle_operation(caller, registry_data, operation, event_id);
+
+   return settle_result {
+      .event_id = event_id,
+      .quantity = quantity
+   };
 }
 
-void adapter::swap(const bytes& event_bytes) {
+swap_result adapter::swap(const bytes& event_bytes) {
    require_auth(get_self());
 
    // IMPORTANT: this is for the tests, vert doesn't correctly
@@ -295,6 +395,119 @@ void adapter::swap(const bytes& event_bytes) {
    // the bc.console
    // NOTE: performance are not affected by this
    printhex(event_bytes.data(), event_bytes.size());
+
+   // Relayers can read these from the action receipt
+   // without re-hashing the event bytes off-chain
+   return swap_result {
+      .nonce = bytes32_to_uint64(extract_32bytes(event_bytes, 0)),
+      .event_hash = sha256((const char*)event_bytes.data(), event_bytes.size())
+   };
+}
+
+adapter_config adapter::getconfig() {
+   registry_adapter _registry(get_self(), get_self().value);
+   check(_registry.exists(), "contract not inizialized");
+
+   storage _storage(get_self(), get_self().value);
+   auto storage = _storage.get_or_default(empty_storage);
+
+   // PAM settings in use, possibly the shared ones
+   name settings = pam::get_settings_account(get_self());
+   pam::tee_pubkey _tee_pubkey(settings, settings.value);
+
+   adapter_config config {
+      .registry = _registry.get(),
+      .nonce = storage.nonce,
+      .feesmanager = storage.feesmanager,
+      .local_chain_id = checksum256(),
+      .tee = _tee_pubkey.get_or_default(),
+      .mappings = {},
+      .pam_registry = settings == get_self() ? name() : settings
+   };
+
+   pam::find_local_chain_id(settings, config.local_chain_id);
+
+   pam::mappings_table _mappings_table(settings, settings.value);
+   for (auto itr = _mappings_table.begin(); itr != _mappings_table.end(); itr++) {
+      config.mappings.push_back(*itr);
+   }
+
+   // Origins not migrated yet
+   pam::mappings_table_v1 _mappings_table_v1(settings, settings.value);
+   for (auto itr = _mappings_table_v1.begin(); itr != _mappings_table_v1.end(); itr++) {
+      if (_mappings_table.find(itr->primary_key()) == _mappings_table.end()) {
+         config.mappings.push_back(pam::from_legacy_mappings(*itr));
+      }
+   }
+
+   return config;
+}
+
+asset adapter::quotefees(const asset& quantity) {
+   check(quantity.is_valid(), "invalid quantity");
+   return calculate_fees(quantity);
+}
+
+vector<bool> adapter::isprocessed(const vector<checksum256>& event_ids) {
+   past_events _past_events(get_self(), get_self().value);
+   auto idx_past_events = _past_events.get_index<adapter_registry_idx_eventid>();
+
+   vector<bool> processed;
+   processed.reserve(event_ids.size());
+   for (const auto& event_id : event_ids) {
+      processed.push_back(idx_past_events.find(event_id) != idx_past_events.end());
+   }
+
+   return processed;
+}
+
+// Mirrors the checks performed by settle without asserting,
+// so relayers can discard operations bound to fail
+pam::status adapter::verify_settle(
+   const operation& operation,
+   const metadata& metadata,
+   checksum256& event_id
+) {
+   registry_adapter _registry(get_self(), get_self().value);
+   if (!_registry.exists()) return pam::status::not_initialized;
+   auto registry_data = _registry.get();
+   if (registry_data.token_bytes != operation.token) return pam::status::invalid_token;
+
+   pam::status status = pam::authorize(get_self(), operation, metadata, event_id);
+   if (status != pam::status::ok) return status;
+
+   past_events _past_events(get_self(), get_self().value);
+   auto idx_past_events = _past_events.get_index<adapter_registry_idx_eventid>();
+   if (idx_past_events.find(event_id) != idx_past_events.end()) return pam::status::already_processed;
+
+   storage _storage(get_self(), get_self().value);
+   if (!_storage.exists()) return pam::status::not_initialized;
+
+   name xerc20 = registry_data.xerc20;
+   if (!is_account(xerc20)) return pam::status::invalid_xerc20;
+
+   lockbox_singleton _lockbox(xerc20, xerc20.value);
+   if (operation.amount > 0 && _lockbox.exists() && !is_account(_lockbox.get()))
+      return pam::status::invalid_lockbox;
+
+   return pam::status::ok;
+}
+
+settle_check adapter::checksettle(const operation& operation, const metadata& metadata) {
+   checksum256 event_id; // output
+   pam::status status = verify_settle(operation, metadata, event_id);
+
+   return settle_check {
+      .code = static_cast<uint8_t>(status),
+      .event_id = event_id
+   };
+}
+
+vector<chain_metrics> adapter::getmetrics() {
+   storage _storage(get_self(), get_self().value);
+   check(_storage.exists(), "adapter contract not initialized");
+
+   return _storage.get().metrics.value_or();
 }
 
 void adapter::token_transfer_from_lockbox(
@@ -330,6 +543,7 @@ void adapter::xerc20_transfer_from_any(
    const asset& quantity,
    const string& memo
 ) {
+   STAGE("swap.fees");
    storage _storage(self, self.value);
    check(_storage.exists(), "contract not initialized");
    auto storage = _storage.get();
@@ -342,26 +556,27 @@ void adapter::xerc20_transfer_from_any(
 
    asset net_amount = quantity - fees;
 
-   action_transfer _transfer{xerc20, {self, "active"_n}};
-   _transfer.send(self, storage.feesmanager, fees, string(""));
-
-   action_burn _burn{xerc20, {self, "active"_n}};
-   _burn.send(self, net_amount, memo);
+   STAGE("swap.burnfee");
+   action_burnfee _burnfee{xerc20, {self, "active"_n}};
+   _burnfee.send(self, quantity, storage.feesmanager, fees);
 
    string sender;
    string dest_chainid;
    string recipient;
    bytes userdata;
 
+   STAGE("swap.memo");
    extract_memo_args(self, memo, sender, dest_chainid, recipient, userdata);
 
+   STAGE("swap.event_bytes");
    auto recipient_bytes = to_bytes(recipient);
+   auto dest_chain_id = hex_to_bytes(dest_chainid);
 
    bytes event_bytes  = concat(
       32 * 6 + recipient_bytes.size() + userdata.size(),
       to_bytes32(storage.nonce),
       to_bytes32(token.to_string()),
-      hex_to_bytes(dest_chainid),
+      dest_chain_id,
       to_bytes32(to_wei(net_amount)),
       to_bytes32(sender),
       to_bytes32(recipient_bytes.size()),
@@ -372,6 +587,18 @@ void adapter::xerc20_transfer_from_any(
    action_swap _swap{self, {self, "active"_n}};
    _swap.send(event_bytes);
 
+   STAGE("swap.storage");
+   // Checked here as well, so the chain id isn't converted for nothing
+   if (storage.metrics.has_value()) {
+      update_metrics(
+         storage,
+         METRICS_DIRECTION_SWAP,
+         bytes32_to_checksum256(dest_chain_id),
+         net_amount,
+         fees,
+         storage.nonce
+      );
+   }
    storage.nonce++;
    _storage.set(storage, self);
 }
@@ -426,4 +653,11 @@ void adapter::ontransfer(const name& from, const name& to, const asset& quantity
 void adapter::onmint(const name& caller, const name& to, const asset& quantity, const string& memo) {
    ontransfer(caller, to, quantity, memo);
 }
+
+// Same as the lockbox, entries crediting other accounts are skipped
+void adapter::onmintbatch(const name& caller, const vector<xtoken::mint_entry>& entries) {
+   for (const auto& entry : entries) {
+      if (entry.to == get_self()) ontransfer(caller, entry.to, entry.quantity, entry.memo);
+   }
+}
 } // namespace eosio
\ No newline at end of file
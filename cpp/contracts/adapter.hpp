@@ -5,12 +5,16 @@
 #include <eosio/system.hpp>
 #include <eosio/singleton.hpp>
 #include <eosio/fixed_bytes.hpp>
+#include <eosio/binary_extension.hpp>
 
 #include <string>
 
 #include "pam.hpp"
 #include "metadata.hpp"
 #include "operation.hpp"
+#include "migration.hpp"
+#include "stages.hpp"
+#include "../codec/memo.hpp"
 #include "xerc20.token.hpp"
 
 #include "tables/token_stats.table.hpp"
@@ -23,9 +27,53 @@ namespace eosio {
    using std::vector;
    using std::make_tuple;
    using eosio::operation;
+   using eosio::operation2;
    using eosio::action_wrapper;
    using bytes = std::vector<uint8_t>;
 
+   // Snapshot of the adapter configuration returned
+   // by the getconfig read-only action
+   struct adapter_config {
+      adapter_registry_table  registry;
+      uint64_t                nonce;
+      name                    feesmanager;
+      checksum256             local_chain_id;
+      pam::tee                tee;
+      vector<pam::mappings>   mappings;
+      name                    pam_registry; // empty when not shared
+   };
+
+   // Result of the checksettle dry-run, code
+   // values are listed in pam::status
+   struct settle_check {
+      uint8_t        code;
+      checksum256    event_id;
+   };
+
+   // Returned by the swap action
+   struct swap_result {
+      uint64_t       nonce;
+      checksum256    event_hash;
+   };
+
+   // Returned by the settle actions
+   struct settle_result {
+      checksum256    event_id;
+      asset          quantity;
+   };
+
+   // Throughput counters relative to a (direction, chain id)
+   // pair, chain id is the destination one for swaps and the
+   // origin one for settlements
+   struct chain_metrics {
+      uint8_t        direction;
+      checksum256    chain_id;
+      uint64_t       count;
+      uint128_t      volume; // xerc20 units
+      uint128_t      fees;   // xerc20 units
+      uint64_t       last_nonce;
+   };
+
    class [[eosio::contract("adapter")]] adapter : public contract {
       public:
          using contract::contract;
@@ -41,6 +89,8 @@ namespace eosio {
 
          ACTION setfeemanagr(const name& fee_manager);
 
+         ACTION setmetrics(bool enabled);
+
          ACTION adduserdata(const name& caller, bytes payload);
 
          ACTION freeuserdata(const name& account);
@@ -53,29 +103,63 @@ namespace eosio {
 
          ACTION setchainid(bytes chain_id);
 
-         ACTION swap(const bytes& event_bytes);
+         ACTION setregistry(const name& registry);
+
+         [[eosio::action]]
+         migration::cursor migrate(uint32_t max_rows);
+
+         [[eosio::action]]
+         swap_result swap(const bytes& event_bytes);
+
+         [[eosio::action]]
+         settle_result settle(const name& caller, const operation& operation, const metadata& metadata);
 
-         ACTION settle(const name& caller, const operation& operation, const metadata& metadata);
+         [[eosio::action]]
+         settle_result settle2(const name& caller, const metadata& metadata);
+
+         [[eosio::action, eosio::read_only]]
+         adapter_config getconfig();
+
+         [[eosio::action, eosio::read_only]]
+         asset quotefees(const asset& quantity);
+
+         [[eosio::action, eosio::read_only]]
+         vector<bool> isprocessed(const vector<checksum256>& event_ids);
+
+         [[eosio::action, eosio::read_only]]
+         settle_check checksettle(const operation& operation, const metadata& metadata);
+
+         [[eosio::action, eosio::read_only]]
+         vector<chain_metrics> getmetrics();
 
          [[eosio::on_notify("*::mint")]]
          void onmint(const name& caller, const name& to, const asset& quantity, const string& memo);
 
+         [[eosio::on_notify("*::mintbatch")]]
+         void onmintbatch(const name& caller, const vector<xtoken::mint_entry>& entries);
+
          [[eosio::on_notify("*::transfer")]]
          void ontransfer(const name& from, const name& to, const asset& quantity, const string& memo);
 
          asset calculate_fees(const asset& quantity);
 
          using action_swap = action_wrapper<"swap"_n, &adapter::swap>;
-         using action_burn = action_wrapper<"burn"_n, &xtoken::burn>;
+         using action_burnfee = action_wrapper<"burnfee"_n, &xtoken::burnfee>;
          using action_mint = action_wrapper<"mint"_n, &xtoken::mint>;
          using action_transfer = action_wrapper<"transfer"_n, &xtoken::transfer>;
       private:
          uint128_t FEE_BASIS_POINTS = 1750;
          uint128_t FEE_BASIS_POINTS_DIVISOR = 1000000; // 4 decimals for basis point + 2 decimals for percentage
 
+         static constexpr uint8_t METRICS_DIRECTION_SWAP = 0;
+         static constexpr uint8_t METRICS_DIRECTION_SETTLE = 1;
+
          TABLE global_storage_table {
             uint64_t nonce;
             name     feesmanager;
+            // Opt-in (see setmetrics), kept here so that updating
+            // the counters doesn't cost an additional table write
+            binary_extension<vector<chain_metrics>> metrics;
          };
 
          // Scoped with user account
@@ -98,6 +182,10 @@ namespace eosio {
          using mappings_table = pam::mappings_table;
          using tee_pubkey = pam::tee_pubkey;
          using chain_id = pam::chain_id;
+         using pam_registry = pam::registry;
+         using mappings_table_v1 = pam::mappings_table_v1;
+         using chain_id_v1 = pam::chain_id_v1;
+         using migration_cursor = migration::cursor_singleton;
 
          global_storage_table empty_storage = {
             .nonce = 0,
@@ -106,6 +194,28 @@ namespace eosio {
 
          void check_symbol_is_valid(const name& account, const symbol& sym);
 
+         void update_metrics(
+            global_storage_table& storage,
+            uint8_t direction,
+            const checksum256& chain_id,
+            const asset& volume,
+            const asset& fees,
+            uint64_t nonce
+         );
+
+         pam::status verify_settle(
+            const operation& operation,
+            const metadata& metadata,
+            checksum256& event_id
+         );
+
+         asset settle_operation(
+            const name& caller,
+            const adapter_registry_table& registry_data,
+            const operation2& operation,
+            const checksum256& event_id
+         );
+
          void extract_memo_args(
             const name& self,
             const string& memo,
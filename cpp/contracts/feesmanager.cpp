@@ -1,11 +1,15 @@
 #include "feesmanager.hpp"
 
+#include <algorithm>
+
 using namespace eosio;
 
 void feesmanager::setallowance( name node, name token, const asset& value ) {
     require_auth(get_self());
 
+    // Fees tracked by the accumulator are owed to the weighted nodes
     auto balance = getbalance(token, value.symbol);
+    balance.amount -= get_tracked(token, value.symbol);
 
     total_allowance_table total_allowance(get_self(), token.value);
     auto total_token_allowance = total_allowance.get_or_create(get_self(), {asset(0, value.symbol)}).allowance.amount;
@@ -44,6 +48,7 @@ void feesmanager::incallowance( name node, name token, const asset& value ) {
     auto total_token_allowance = total_allowance.get().allowance.amount;
 
     auto balance = getbalance(token, value.symbol);
+    balance.amount -= get_tracked(token, value.symbol);
     check(balance.amount >= total_token_allowance + value.amount, "[increase allowance]: balance is lower than the allowance to be set");
 
     total_allowance.set({asset(total_token_allowance + value.amount , value.symbol)}, get_self());
@@ -53,29 +58,89 @@ void feesmanager::incallowance( name node, name token, const asset& value ) {
 }
 
 void feesmanager::withdrawto( name node, name token, symbol token_symbol ) {
-    allowances_table allowances(get_self(), node.value);
-
-    const auto& allowance_table = allowances.get(token_symbol.code().raw(), "No allowance set for this node");
-    asset asset_data = asset(allowance_table.node_allowance.amount, token_symbol);
+    require_node_or_self(node);
+    auto amount = take_allowance(node, token, token_symbol);
 
     total_allowance_table total_allowance(get_self(), token.value);
     auto total_token_allowance = total_allowance.get().allowance.amount;
+    total_allowance.set({asset(total_token_allowance - amount , token_symbol)}, get_self());
 
-    allowances.modify(allowance_table, node, [&](auto& a) {
-        a.node_allowance.amount = 0;
-    });
-    total_allowance.set({asset(total_token_allowance - asset_data.amount , token_symbol)}, get_self());
-    
     action_transfer _transfer(token, { get_self(), "active"_n });
-    _transfer.send(get_self(), node, asset_data, std::string("Withdraw"));
+    _transfer.send(get_self(), node, asset(amount, token_symbol), std::string("Withdraw"));
 }
 
-// FIXME: multiple withdraw do not work currently
+// Many tokens to one node, each totallowance singleton is
+// read and written once and the transfers are sorted by token
 void feesmanager::withdrawmtto(name node, const std::vector<name>& tokens, const std::vector<symbol>& token_symbols) {
+    require_node_or_self(node);
     check(tokens.size() == token_symbols.size(), "Token names and symbol size mismatch");
+
+    std::vector<std::pair<name, asset>> withdrawals;
+    withdrawals.reserve(tokens.size());
     for (size_t i = 0; i < tokens.size(); ++i) {
-        withdrawto(node, tokens[i], token_symbols[i]);
+        auto amount = take_allowance(node, tokens[i], token_symbols[i]);
+        if (amount > 0) withdrawals.push_back({tokens[i], asset(amount, token_symbols[i])});
+    }
+
+    std::sort(withdrawals.begin(), withdrawals.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    for (size_t i = 0; i < withdrawals.size();) {
+        auto token = withdrawals[i].first;
+        total_allowance_table total_allowance(get_self(), token.value);
+        auto total_token_allowance = total_allowance.get();
+
+        for (; i < withdrawals.size() && withdrawals[i].first == token; ++i) {
+            total_token_allowance.allowance.amount -= withdrawals[i].second.amount;
+
+            action_transfer _transfer(token, { get_self(), "active"_n });
+            _transfer.send(get_self(), node, withdrawals[i].second, std::string("Withdraw"));
+        }
+
+        total_allowance.set(total_token_allowance, get_self());
+    }
+}
+
+// Many nodes for one token in a single admin triggered payout
+void feesmanager::distribute(name token, symbol token_symbol, const std::vector<name>& nodes) {
+    require_auth(get_self());
+
+    total_allowance_table total_allowance(get_self(), token.value);
+    auto total_token_allowance = total_allowance.get();
+
+    action_transfer _transfer(token, { get_self(), "active"_n });
+    for (const auto& node : nodes) {
+        auto amount = take_allowance(node, token, token_symbol);
+        if (amount == 0) continue;
+
+        total_token_allowance.allowance.amount -= amount;
+        _transfer.send(get_self(), node, asset(amount, token_symbol), std::string("Withdraw"));
     }
+
+    total_allowance.set(total_token_allowance, get_self());
+}
+
+// Payouts are triggered by the node itself or by the contract
+// (the RAM payer of the allowance rows), never by third parties
+void feesmanager::require_node_or_self(name node) {
+    if (!has_auth(get_self())) require_auth(node);
+}
+
+// Zeroes the node allowance returning the withdrawable amount
+int64_t feesmanager::take_allowance(name node, name token, symbol token_symbol) {
+    allowances_table allowances(get_self(), node.value);
+    const auto& allowance_table = allowances.get(token_symbol.code().raw(), "No allowance set for this node");
+    check(allowance_table.token == token, "symbol and token do not match");
+    auto amount = allowance_table.node_allowance.amount;
+
+    if (amount > 0) {
+        allowances.modify(allowance_table, same_payer, [&](auto& a) {
+            a.node_allowance.amount = 0;
+        });
+    }
+
+    return amount;
 }
 
 asset feesmanager::getbalance(name token, symbol token_symbol) {
@@ -86,4 +151,161 @@ asset feesmanager::getbalance(name token, symbol token_symbol) {
     } else {
         return asset(0, token_symbol);
     }
-}
\ No newline at end of file
+}
+
+void feesmanager::addpool( name token, symbol token_symbol ) {
+    require_auth(get_self());
+    check(token_symbol.is_valid(), "invalid symbol");
+
+    pools_table pools(get_self(), get_self().value);
+    auto pools_idx = pools.get_index<"bytoken"_n>();
+    check(pools_idx.find(get_pool_key(token, token_symbol)) == pools_idx.end(), "pool already exists");
+
+    pools.emplace(get_self(), [&](auto& p) {
+        p.id = pools.available_primary_key();
+        p.token = token;
+        p.token_symbol = token_symbol;
+        p.acc_per_share = 0;
+        p.tracked = 0;
+    });
+}
+
+// Pending rewards are settled on every pool before the weight
+// changes, this is the only operation scaling with the pools number
+void feesmanager::setweight( name node, uint64_t weight ) {
+    require_auth(get_self());
+    check(weight <= MAX_WEIGHT, "weight too high");
+
+    weights_table weights(get_self(), get_self().value);
+    auto weight_itr = weights.find(node.value);
+    uint64_t old_weight = weight_itr != weights.end() ? weight_itr->weight : 0;
+
+    pools_table pools(get_self(), get_self().value);
+    for (auto itr = pools.begin(); itr != pools.end(); itr++) {
+        sync_pool(pools, *itr);
+        settle_node(node, old_weight, *itr, false);
+    }
+
+    total_weight_table total_weight(get_self(), get_self().value);
+    auto total = total_weight.get_or_default({0}).weight;
+    total_weight.set({total - old_weight + weight}, get_self());
+
+    if (weight_itr == weights.end()) {
+        weights.emplace(get_self(), [&](auto& w) {
+            w.node = node;
+            w.weight = weight;
+        });
+    } else if (weight == 0) {
+        weights.erase(weight_itr);
+    } else {
+        weights.modify(weight_itr, get_self(), [&](auto& w) {
+            w.weight = weight;
+        });
+    }
+}
+
+void feesmanager::claim( name node, name token, symbol token_symbol ) {
+    require_node_or_self(node);
+
+    pools_table pools(get_self(), get_self().value);
+    const auto& pool = get_pool(pools, token, token_symbol);
+    sync_pool(pools, pool);
+
+    weights_table weights(get_self(), get_self().value);
+    auto weight_itr = weights.find(node.value);
+    uint64_t weight = weight_itr != weights.end() ? weight_itr->weight : 0;
+
+    auto amount = settle_node(node, weight, pool, true);
+    check(amount > 0, "nothing to claim");
+
+    pools.modify(pool, get_self(), [&](auto& p) {
+        p.tracked -= amount;
+    });
+
+    action_transfer _transfer(token, { get_self(), "active"_n });
+    _transfer.send(get_self(), node, asset(amount, token_symbol), std::string("Claim"));
+}
+
+asset feesmanager::getclaimable( name node, name token, symbol token_symbol ) {
+    pools_table pools(get_self(), get_self().value);
+    const auto& pool = get_pool(pools, token, token_symbol);
+
+    weights_table weights(get_self(), get_self().value);
+    auto weight_itr = weights.find(node.value);
+    uint64_t weight = weight_itr != weights.end() ? weight_itr->weight : 0;
+
+    // Same as sync_pool + settle_node without writing
+    uint128_t acc_per_share = pool.acc_per_share;
+    total_weight_table total_weight(get_self(), get_self().value);
+    auto total = total_weight.get_or_default({0}).weight;
+    if (total > 0) {
+        total_allowance_table total_allowance(get_self(), token.value);
+        auto reserved = total_allowance.get_or_default({asset(0, token_symbol)}).allowance.amount;
+        auto received = getbalance(token, token_symbol).amount - reserved - pool.tracked;
+        if (received > 0) acc_per_share += (uint128_t(received) << ACC_PRECISION_BITS) / total;
+    }
+
+    rewards_table rewards(get_self(), node.value);
+    auto reward_itr = rewards.find(pool.id);
+    uint128_t debt_per_share = reward_itr != rewards.end() ? reward_itr->debt_per_share : 0;
+    int64_t pending = reward_itr != rewards.end() ? reward_itr->pending : 0;
+
+    pending += int64_t((uint128_t(weight) * (acc_per_share - debt_per_share)) >> ACC_PRECISION_BITS);
+    return asset(pending, token_symbol);
+}
+
+// Accounts the fees received since the last sync: anything in the balance
+// not reserved by the allowances and not tracked yet by the pool
+void feesmanager::sync_pool( pools_table& pools, const reward_pool& pool ) {
+    total_weight_table total_weight(get_self(), get_self().value);
+    auto total = total_weight.get_or_default({0}).weight;
+    if (total == 0) return;
+
+    total_allowance_table total_allowance(get_self(), pool.token.value);
+    auto reserved = total_allowance.get_or_default({asset(0, pool.token_symbol)}).allowance.amount;
+    auto received = getbalance(pool.token, pool.token_symbol).amount - reserved - pool.tracked;
+    if (received <= 0) return;
+
+    pools.modify(pool, get_self(), [&](auto& p) {
+        p.acc_per_share += (uint128_t(received) << ACC_PRECISION_BITS) / total;
+        p.tracked += received;
+    });
+}
+
+// Moves the node rewards accrued so far into its pending amount,
+// which is zeroed when withdrawing
+int64_t feesmanager::settle_node( name node, uint64_t weight, const reward_pool& pool, bool withdraw ) {
+    rewards_table rewards(get_self(), node.value);
+    auto itr = rewards.find(pool.id);
+
+    if (itr == rewards.end()) {
+        int64_t pending = int64_t((uint128_t(weight) * pool.acc_per_share) >> ACC_PRECISION_BITS);
+        rewards.emplace(get_self(), [&](auto& r) {
+            r.pool_id = pool.id;
+            r.debt_per_share = pool.acc_per_share;
+            r.pending = withdraw ? 0 : pending;
+        });
+        return pending;
+    }
+
+    int64_t pending = itr->pending + int64_t((uint128_t(weight) * (pool.acc_per_share - itr->debt_per_share)) >> ACC_PRECISION_BITS);
+    rewards.modify(itr, get_self(), [&](auto& r) {
+        r.debt_per_share = pool.acc_per_share;
+        r.pending = withdraw ? 0 : pending;
+    });
+    return pending;
+}
+
+int64_t feesmanager::get_tracked( name token, symbol token_symbol ) {
+    pools_table pools(get_self(), get_self().value);
+    auto pools_idx = pools.get_index<"bytoken"_n>();
+    auto itr = pools_idx.find(get_pool_key(token, token_symbol));
+    return itr != pools_idx.end() ? itr->tracked : 0;
+}
+
+const feesmanager::reward_pool& feesmanager::get_pool( pools_table& pools, name token, symbol token_symbol ) {
+    auto pools_idx = pools.get_index<"bytoken"_n>();
+    auto itr = pools_idx.find(get_pool_key(token, token_symbol));
+    check(itr != pools_idx.end(), "pool not found");
+    return *itr;
+}
@@ -20,9 +20,20 @@ public:
 
     ACTION withdrawmtto(name node, const std::vector<name>& tokens, const std::vector<symbol>& token_symbols);
 
+    ACTION distribute(name token, symbol token_symbol, const std::vector<name>& nodes);
+
+    ACTION addpool(name token, symbol token_symbol);
+
+    ACTION setweight(name node, uint64_t weight);
+
+    ACTION claim(name node, name token, symbol token_symbol);
+
     [[eosio::action]]
     asset getbalance(name token, symbol token_symbol);
 
+    [[eosio::action, eosio::read_only]]
+    asset getclaimable(name node, name token, symbol token_symbol);
+
     using action_transfer = action_wrapper<"transfer"_n, &xtoken::transfer>;
 private:
     TABLE account {
@@ -43,7 +54,58 @@ private:
         uint64_t get_name()const { return token.value; }
     };
 
+    // Accumulator mode: the fees received by a pool are shared among
+    // the registered nodes proportionally to their weight
+    static constexpr uint8_t ACC_PRECISION_BITS = 32;
+    static constexpr uint64_t MAX_WEIGHT = 1ULL << 32;
+
+    TABLE reward_pool {
+        uint64_t id;
+        name token;
+        symbol token_symbol;
+        uint128_t acc_per_share; // fixed-point (ACC_PRECISION_BITS)
+        int64_t tracked;         // received and not claimed yet
+
+        uint64_t primary_key()const { return id; }
+        uint128_t by_token()const { return get_pool_key(token, token_symbol); }
+    };
+
+    TABLE node_weight {
+        name node;
+        uint64_t weight;
+
+        uint64_t primary_key()const { return node.value; }
+    };
+
+    TABLE total_weight {
+        uint64_t weight;
+    };
+
+    // Scoped by node
+    TABLE node_reward {
+        uint64_t pool_id;
+        uint128_t debt_per_share;
+        int64_t pending;
+
+        uint64_t primary_key()const { return pool_id; }
+    };
+
+    static uint128_t get_pool_key(name token, symbol token_symbol) {
+        return (uint128_t(token.value) << 64) | token_symbol.code().raw();
+    }
+
     typedef eosio::singleton<"totallowance"_n, total_allowance> total_allowance_table;
     typedef eosio::multi_index<"accounts"_n, account> accounts;
+    typedef eosio::multi_index<"pools"_n, reward_pool, eosio::indexed_by<"bytoken"_n, eosio::const_mem_fun<reward_pool, uint128_t, &reward_pool::by_token>>> pools_table;
+    typedef eosio::multi_index<"weights"_n, node_weight> weights_table;
+    typedef eosio::singleton<"totalweight"_n, total_weight> total_weight_table;
+    typedef eosio::multi_index<"rewards"_n, node_reward> rewards_table;
     typedef eosio::multi_index<"allowances"_n, allowance, eosio::indexed_by<"name"_n, eosio::const_mem_fun<allowance, uint64_t, &allowance::get_name>>> allowances_table;
+
+    void require_node_or_self(name node);
+    int64_t take_allowance(name node, name token, symbol token_symbol);
+    void sync_pool(pools_table& pools, const reward_pool& pool);
+    int64_t settle_node(name node, uint64_t weight, const reward_pool& pool, bool withdraw);
+    int64_t get_tracked(name token, symbol token_symbol);
+    const reward_pool& get_pool(pools_table& pools, name token, symbol token_symbol);
 };
\ No newline at end of file
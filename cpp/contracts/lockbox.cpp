@@ -26,12 +26,61 @@ void lockbox::create(
    check_symbol_is_valid(token, token_symbol);
 
 
-   _registry.emplace( get_self(), [&]( auto& r ) {
+   const auto& pair = *_registry.emplace( get_self(), [&]( auto& r ) {
        r.xerc20 = xerc20;
        r.xerc20_symbol = xerc20_symbol;
        r.token = token;
        r.token_symbol = token_symbol;
    });
+
+   check(add_routes(pair), "xERC20 already registered");
+}
+
+// Adds the routes of the pairs registered before the routes
+// table was introduced, see migration.hpp
+migration::cursor lockbox::migrate(uint32_t max_rows) {
+   require_auth(get_self());
+
+   return migration::run(get_self(), max_rows,
+      // reglockbox -> routes (MIGRATION_STEP_ROUTES)
+      [&](uint32_t budget) {
+         registry _registry(get_self(), get_self().value);
+         return migration::scan(get_self(), _registry, budget, [&](const auto& pair) {
+            add_routes(pair);
+         });
+      }
+   );
+}
+
+bool lockbox::add_routes(const lockbox_registry_table& pair) {
+   routes _wrap_routes(get_self(), pair.token.value);
+   routes _unwrap_routes(get_self(), pair.xerc20.value);
+
+   auto wrap_itr = _wrap_routes.find(pair.token_symbol.code().raw());
+   auto unwrap_itr = _unwrap_routes.find(pair.xerc20_symbol.code().raw());
+   if (wrap_itr != _wrap_routes.end() || unwrap_itr != _unwrap_routes.end()) return false;
+
+   // The collateral already held is accounted as deposited
+   // so the outstanding amount matches the locked one
+   auto locked = get_locked(pair.token, pair.token_symbol);
+
+   _wrap_routes.emplace(get_self(), [&](auto& r) {
+      r.sym = pair.token_symbol;
+      r.direction = lockbox_route_wrap;
+      r.counterpart = pair.xerc20;
+      r.counterpart_symbol = pair.xerc20_symbol;
+      r.total = locked.amount;
+   });
+
+   _unwrap_routes.emplace(get_self(), [&](auto& r) {
+      r.sym = pair.xerc20_symbol;
+      r.direction = lockbox_route_unwrap;
+      r.counterpart = pair.token;
+      r.counterpart_symbol = pair.token_symbol;
+      r.total = 0;
+   });
+
+   return true;
 }
 
 void lockbox::ontransfer(
@@ -45,11 +94,87 @@ void lockbox::ontransfer(
    check(to == get_self(), "recipient must be the contract");
    check(quantity.amount > 0, "invalid amount");
 
+   STAGE("lockbox.route");
    name token = get_first_receiver();
+   routes _routes(get_self(), token.value);
+   auto route = _routes.find(quantity.symbol.code().raw());
+
+   if (route == _routes.end()) {
+      // Pairs not migrated yet
+      check(!migration::is_completed(get_self(), MIGRATION_STEP_ROUTES), "token not registered");
+      return legacy_transfer(token, from, quantity, memo);
+   }
+
+   check(route->sym == quantity.symbol, "invalid symbol");
+
+   auto counterpart_quantity = asset(quantity.amount, route->counterpart_symbol);
+
+   _routes.modify(route, same_payer, [&](auto& r) {
+      r.total += quantity.amount;
+   });
+
+   if (route->direction == lockbox_route_wrap) {
+      STAGE("lockbox.wrap");
+      action_mint _mint(route->counterpart, {get_self(), "active"_n});
+      _mint.send(get_self(), from, counterpart_quantity, memo);
+   } else {
+      STAGE("lockbox.unwrap");
+      action_burn _burn(token, { get_self(), "active"_n });
+      _burn.send(get_self(), quantity, memo);
+
+      action_transfer _transfer(route->counterpart, { get_self(), "active"_n });
+      _transfer.send(get_self(), from, counterpart_quantity, memo);
+   }
+}
+
+vector<pair_collateral> lockbox::getcollat() {
+   registry _registry(get_self(), get_self().value);
+
+   vector<pair_collateral> collaterals;
+   for (auto itr = _registry.begin(); itr != _registry.end(); itr++) {
+      routes _wrap_routes(get_self(), itr->token.value);
+      routes _unwrap_routes(get_self(), itr->xerc20.value);
+      auto wrap = _wrap_routes.find(itr->token_symbol.code().raw());
+      auto unwrap = _unwrap_routes.find(itr->xerc20_symbol.code().raw());
+
+      auto deposited = asset(wrap != _wrap_routes.end() ? wrap->total : 0, itr->token_symbol);
+      auto released = asset(unwrap != _unwrap_routes.end() ? unwrap->total : 0, itr->token_symbol);
+
+      stats _stats(itr->xerc20, itr->xerc20_symbol.code().raw());
+      auto stat = _stats.find(itr->xerc20_symbol.code().raw());
+
+      collaterals.push_back({
+         .token = itr->token,
+         .deposited = deposited,
+         .released = released,
+         .outstanding = deposited - released,
+         .locked = get_locked(itr->token, itr->token_symbol),
+         .xerc20 = itr->xerc20,
+         .supply = stat != _stats.end() ? stat->supply : asset(0, itr->xerc20_symbol)
+      });
+   }
+
+   return collaterals;
+}
+
+asset lockbox::get_locked(const name& token, const symbol& sym) {
+   accounts _accounts(token, get_self().value);
+   auto itr = _accounts.find(sym.code().raw());
+   return itr != _accounts.end() ? itr->balance : asset(0, sym);
+}
+
+// Resolves the pair from the reglockbox table, as done
+// before the routes were introduced
+void lockbox::legacy_transfer(
+   const name& token,
+   const name& from,
+   const asset& quantity,
+   const string& memo
+) {
    registry _registry(get_self(), get_self().value);
    auto search_token = _registry.find(quantity.symbol.code().raw());
    auto idx = _registry.get_index<lockbox_registry_idx_xtoken_name>();
-   auto search_xerc20 = idx.lower_bound(quantity.symbol.code().raw());
+   auto search_xerc20 = idx.find(quantity.symbol.code().raw());
 
    check(
       search_token != _registry.end() ||
@@ -63,8 +188,7 @@ void lockbox::ontransfer(
 
       action_mint _mint(search_token->xerc20, {get_self(), "active"_n});
       _mint.send(get_self(), from, xerc20_quantity, memo);
-   } else if (search_xerc20 != idx.end()) {
-
+   } else {
       check(search_xerc20->xerc20 == token, "invalid first receiver");
 
       action_burn _burn(token, { get_self(), "active"_n });
@@ -80,4 +204,11 @@ void lockbox::ontransfer(
 void lockbox::onmint(const name& from, const name& to, const asset& quantity, const string& memo) {
    ontransfer(from, to, quantity, memo);
 }
+
+// Notified once however many entries credit the lockbox
+void lockbox::onmintbatch(const name& caller, const vector<xtoken::mint_entry>& entries) {
+   for (const auto& entry : entries) {
+      if (entry.to == get_self()) ontransfer(caller, entry.to, entry.quantity, entry.memo);
+   }
+}
 }
\ No newline at end of file
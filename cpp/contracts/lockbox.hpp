@@ -8,11 +8,26 @@
 #include <string>
 
 #include "xerc20.token.hpp"
+#include "migration.hpp"
 #include "tables/token_stats.table.hpp"
 #include "tables/lockbox_registry.table.hpp"
+#include "tables/lockbox_route.table.hpp"
 
 namespace eosio {
    using std::string;
+   using std::vector;
+
+   // Collateral locked for a pair against the xERC20 supply, the
+   // outstanding amount is expected to match both locked and supply
+   struct pair_collateral {
+      name     token;
+      asset    deposited;
+      asset    released;
+      asset    outstanding;
+      asset    locked;
+      name     xerc20;
+      asset    supply;
+   };
 
    class [[eosio::contract("lockbox")]] lockbox : public contract {
       public:
@@ -25,23 +40,50 @@ namespace eosio {
             const symbol& token_symbol
          );
 
+         [[eosio::action]]
+         migration::cursor migrate(uint32_t max_rows);
+
+         [[eosio::action, eosio::read_only]]
+         vector<pair_collateral> getcollat();
+
          [[eosio::on_notify("*::transfer")]]
          void ontransfer(const name& from, const name& to, const asset& quantity, const string& memo);
 
          [[eosio::on_notify("*::mint")]]
          void onmint(const name& from, const name& to, const asset& quantity, const string& memo);
 
+         [[eosio::on_notify("*::mintbatch")]]
+         void onmintbatch(const name& caller, const vector<xtoken::mint_entry>& entries);
+
          using action_burn = action_wrapper<"burn"_n, &xtoken::burn>;
          using action_mint = action_wrapper<"mint"_n, &xtoken::mint>;
          using action_transfer = action_wrapper<"transfer"_n, &xtoken::transfer>;
+
+         // Index of the reglockbox -> routes step of migrate
+         static constexpr uint8_t MIGRATION_STEP_ROUTES = 0;
       private:
+         TABLE account {
+            asset    balance;
+
+            uint64_t primary_key()const { return balance.symbol.code().raw(); }
+         };
+
+         typedef eosio::multi_index<"accounts"_n, account> accounts;
          typedef eosio::multi_index<"stat"_n, token_stats_table > stats;
          typedef eosio::multi_index<
             "reglockbox"_n,
             lockbox_registry_table,
             lockbox_registry_byxtoken
          > registry;
+         typedef eosio::multi_index<"routes"_n, lockbox_route_table> routes;
+
+         // Define alias for ABI inclusion
+         using migration_cursor = migration::cursor_singleton;
+         using migration_position = migration::position_singleton;
 
          void check_symbol_is_valid(const name& account, const symbol& sym);
+         bool add_routes(const lockbox_registry_table& pair);
+         asset get_locked(const name& token, const symbol& sym);
+         void legacy_transfer(const name& token, const name& from, const asset& quantity, const string& memo);
    };
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <eosio/eosio.hpp>
+#include <eosio/singleton.hpp>
+
+namespace eosio {
+   namespace migration {
+      // Progress of the chunked migrations of a contract: the legacy
+      // tables are drained in order, step is the index of the one
+      // being migrated. Steps are append only, a later layout change
+      // adds its steps at the end of the list and the same cursor
+      // resumes from there (done is reset on the next run).
+      TABLE cursor {
+         uint8_t  step = 0;
+         uint64_t migrated = 0;
+         bool     done = false;
+      };
+
+      using cursor_singleton = singleton<"migration"_n, cursor>;
+
+      // Next key to visit for the steps updating a table in place
+      // (see scan), removed once the step is completed
+      TABLE position {
+         uint64_t next = 0;
+      };
+
+      using position_singleton = singleton<"migrationpos"_n, position>;
+
+      // Whether the given step has been completed, i.e. all its
+      // rows have been migrated, so the dual-read can skip it
+      inline bool is_completed(const name& self, uint8_t step) {
+         cursor_singleton _cursor(self, self.value);
+         return _cursor.exists() && _cursor.get().step > step;
+      }
+
+      // Moves up to max_rows rows of the legacy table through
+      // move_row (which writes them with the new layout) and
+      // erases them, returns the number of moved rows.
+      template<typename Table, typename Fn>
+      uint32_t drain(Table& legacy, uint32_t max_rows, Fn&& move_row) {
+         uint32_t moved = 0;
+         auto itr = legacy.begin();
+         while (moved < max_rows && itr != legacy.end()) {
+            move_row(*itr);
+            itr = legacy.erase(itr);
+            moved++;
+         }
+
+         return moved;
+      }
+
+      // Same as drain for the tables which are kept: visits up to
+      // max_rows rows through visit and saves where to resume from,
+      // returns the number of visited rows.
+      template<typename Table, typename Fn>
+      uint32_t scan(const name& self, Table& table, uint32_t max_rows, Fn&& visit) {
+         position_singleton _position(self, self.value);
+         auto itr = table.lower_bound(_position.get_or_default().next);
+
+         uint32_t visited = 0;
+         uint64_t last = 0;
+         while (visited < max_rows && itr != table.end()) {
+            visit(*itr);
+            last = itr->primary_key();
+            itr++;
+            visited++;
+         }
+
+         // Completed, see run
+         if (visited < max_rows) {
+            if (_position.exists()) _position.remove();
+         } else {
+            _position.set(position{ .next = last + 1 }, self);
+         }
+
+         return visited;
+      }
+
+      // Runs the given steps in order sharing a budget of max_rows
+      // rows, each step is called with the remaining budget and
+      // returns the rows it has moved. A step moving less rows than
+      // its budget is completed, the next call resumes from the
+      // first uncompleted one.
+      //
+      // NOTE: until a step is completed contracts must fallback on
+      // its legacy table when a row is not found (dual-read), see
+      // is_completed.
+      template<typename... Steps>
+      cursor run(const name& self, uint32_t max_rows, Steps&&... steps) {
+         check(max_rows > 0, "max_rows must be greater than zero");
+
+         cursor_singleton _cursor(self, self.value);
+         auto progress = _cursor.get_or_default();
+         check(progress.step < sizeof...(Steps), "migration already completed");
+
+         uint8_t index = 0;
+         uint32_t budget = max_rows;
+         auto run_step = [&](auto&& step) {
+            if (index++ < progress.step || budget == 0) return;
+
+            uint32_t moved = step(budget);
+            progress.migrated += moved;
+            budget -= moved;
+
+            if (budget > 0) progress.step = index;
+         };
+         (run_step(steps), ...);
+
+         progress.done = progress.step == sizeof...(Steps);
+         _cursor.set(progress, self);
+
+         return progress;
+      }
+   }
+}
@@ -6,6 +6,8 @@
 namespace eosio {
    using bytes = std::vector<uint8_t>;
 
+   // NOTE: action ABI of settle and checksettle (and of the
+   // receivers notifications), its layout must not change
    struct operation {
    public:
       bytes blockId;
@@ -19,4 +21,20 @@ namespace eosio {
       name recipient;
       bytes data;
    };
+
+   // Same as above with the 32 bytes fields stored as fixed
+   // width values, derived from the preimage by settle2
+   struct operation2 {
+   public:
+      checksum256 blockId;
+      checksum256 txId;
+      uint64_t nonce;
+      checksum256 token; // erc20 on EVM
+      checksum256 originChainId;
+      checksum256 destinationChainId;
+      uint128_t amount;
+      bytes sender;
+      name recipient;
+      bytes data;
+   };
 }
\ No newline at end of file
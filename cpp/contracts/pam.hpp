@@ -1,35 +1,45 @@
 #pragma once
 
 #include <eosio/crypto.hpp>
+#include <eosio/system.hpp>
 #include <eosio/singleton.hpp>
 
 #include "utils.hpp"
 #include "metadata.hpp"
 #include "operation.hpp"
+#include "stages.hpp"
+#include "../codec/preimage.hpp"
+#include "../codec/operation.hpp"
 
 namespace eosio {
     using bytes = std::vector<uint8_t>;
     namespace pam {
 
+        // Origin chain settings, all the values are 32 bytes long,
+        // so they are stored as fixed width fields
         TABLE mappings {
+            checksum256 chain_id;
+            checksum256 emitter;
+            checksum256 topic_zero;
+
+            uint64_t primary_key() const { return get_mappings_key(chain_id); }
+        };
+
+        TABLE local_chain_id {
+            checksum256 chain_id;
+        };
+
+        // Layout of the tables above before v2, kept in the
+        // ABI for the migration only (see adapter::migrate)
+        TABLE mappings_v1 {
             bytes chain_id;
             bytes emitter;
             bytes topic_zero;
 
-            uint64_t primary_key() const {
-            eosio::check(chain_id.size() == 32, "Chain ID must be 32 bytes long.");
-            return (static_cast<uint64_t>(chain_id[24]) << 56) |
-                (static_cast<uint64_t>(chain_id[25]) << 48) |
-                (static_cast<uint64_t>(chain_id[26]) << 40) |
-                (static_cast<uint64_t>(chain_id[27]) << 32) |
-                (static_cast<uint64_t>(chain_id[28]) << 24) |
-                (static_cast<uint64_t>(chain_id[29]) << 16) |
-                (static_cast<uint64_t>(chain_id[30]) << 8)  |
-                (static_cast<uint64_t>(chain_id[31]));
-            }
+            uint64_t primary_key() const { return get_mappings_key(chain_id); }
         };
 
-        TABLE local_chain_id {
+        TABLE local_chain_id_v1 {
             bytes chain_id;
         };
 
@@ -41,73 +51,302 @@ namespace eosio {
             uint64_t change_grace_threshold = 0;
         };
 
-        using chain_id = singleton<"chainid"_n, local_chain_id>;
+        using chain_id = singleton<"chainid2"_n, local_chain_id>;
         using tee_pubkey = singleton<"tee"_n, tee>;
-        typedef eosio::multi_index<"mappings"_n, mappings> mappings_table;
+        typedef eosio::multi_index<"mappings2"_n, mappings> mappings_table;
+
+        // Account of the shared settings (see pam.registry.hpp), when
+        // set the tables above are read from there instead of the
+        // adapter's own ones
+        using registry = singleton<"pamregistry"_n, name>;
+
+        using chain_id_v1 = singleton<"chainid"_n, local_chain_id_v1>;
+        typedef eosio::multi_index<"mappings"_n, mappings_v1> mappings_table_v1;
 
         static constexpr uint64_t TEE_ADDRESS_CHANGE_GRACE_PERIOD = 172800; // 48 hours
 
+        // Preimage layout and protocol ids are shared with
+        // the off-chain tools (see codec/preimage.hpp)
+        using pnetwork::codec::PROTOCOL_EOS;
+        using pnetwork::codec::PROTOCOL_EOS_BINARY;
+        using pnetwork::codec::EVENT_PAYLOAD_OFFSET;
+        using pnetwork::codec::EVENT_DATA_OFFSET;
+        using pnetwork::codec::SWAP_EVENT_HEADER_SIZE;
+
+        // Result codes of the authorization checks, values
+        // are part of the checksettle API, append new ones
+        // at the end.
+        enum class status : uint8_t {
+            ok = 0,
+            unexpected_context = 1,
+            local_chain_id_not_set = 2,
+            tee_not_set = 3,
+            origin_chain_id_not_registered = 4,
+            invalid_signature = 5,
+            unexpected_emitter = 6,
+            unexpected_topic_zero = 7,
+            invalid_nonce = 8,
+            invalid_token_address = 9,
+            invalid_destination_chain_id = 10,
+            invalid_local_chain_id = 11,
+            invalid_amount = 12,
+            invalid_sender = 13,
+            invalid_recipient = 14,
+            invalid_account = 15,
+            invalid_user_data = 16,
+            // Adapter checks
+            not_initialized = 17,
+            invalid_token = 18,
+            already_processed = 19,
+            invalid_xerc20 = 20,
+            invalid_lockbox = 21,
+            // Preimage checks
+            invalid_preimage = 22,
+            malformed_signature = 23,
+            invalid_event_data = 24,
+            malformed_event = 25,
+            invalid_number = 26,
+            invalid_recipient_len = 27
+        };
+
+        const char* get_status_message(status s) {
+            switch (s) {
+                case status::ok: return "ok";
+                case status::unexpected_context: return "unexpected context";
+                case status::local_chain_id_not_set: return "local chain id singleton not set";
+                case status::tee_not_set: return "tee singleton not set";
+                case status::origin_chain_id_not_registered: return "origin chain_id not registered";
+                case status::invalid_signature: return "invalid signature";
+                case status::unexpected_emitter: return "unexpected emitter";
+                case status::unexpected_topic_zero: return "unexpected topic zero";
+                case status::invalid_nonce: return "nonce do not match";
+                case status::invalid_token_address: return "token address do not match";
+                case status::invalid_destination_chain_id: return "destination chain id does not match with the expected one";
+                case status::invalid_local_chain_id: return "destination chain id does not match with the current chain";
+                case status::invalid_amount: return "amount do not match";
+                case status::invalid_sender: return "sender do not match";
+                case status::invalid_recipient: return "recipient do not match";
+                case status::invalid_account: return "invalid account";
+                case status::invalid_user_data: return "user data do not match";
+                case status::not_initialized: return "contract not initialized";
+                case status::invalid_token: return "underlying token does not match with adapter registry";
+                case status::already_processed: return "event already processed";
+                case status::invalid_xerc20: return "Not valid xerc20 name";
+                case status::invalid_lockbox: return "lockbox must be a valid account";
+                case status::invalid_preimage: return "preimage shorter than the event payload";
+                case status::malformed_signature: return "signature must be exactly 65 bytes";
+                case status::invalid_event_data: return "invalid utf-8 encoded string";
+                case status::malformed_event: return "event data shorter than the swap event header";
+                case status::invalid_number: return "number exceeds the event field width";
+                case status::invalid_recipient_len: return "recipient exceeds data field";
+            }
+            return "unknown status";
+        }
+
+        mappings from_legacy_mappings(const mappings_v1& legacy) {
+            return mappings {
+                .chain_id = bytes32_to_checksum256(legacy.chain_id),
+                .emitter = bytes32_to_checksum256(legacy.emitter),
+                .topic_zero = bytes32_to_checksum256(legacy.topic_zero)
+            };
+        }
+
+        name get_settings_account(name adapter) {
+            registry _registry(adapter, adapter.value);
+            return _registry.exists() ? _registry.get() : adapter;
+        }
+
+        // Setters shared by the adapter and the registry, self is
+        // the account owning the tables
+        void set_local_chain_id(name self, const bytes& chain_id) {
+            check(chain_id.size() == 32, "expected 32 bytes chain_id");
+            pam::chain_id _chain_id(self, self.value);
+
+            _chain_id.set(local_chain_id{
+                .chain_id = bytes32_to_checksum256(chain_id)
+            }, self);
+        }
+
+        void set_tee(name self, const public_key& pub_key, const bytes& attestation) {
+            tee_pubkey _tee_pubkey(self, self.value);
+
+            if (!_tee_pubkey.exists()) {
+                _tee_pubkey.set(tee{
+                    .key = pub_key,
+                    .updating_key = public_key(),
+                    .attestation = attestation,
+                    .updating_attestation = {},
+                    .change_grace_threshold = 0
+                }, self);
+            } else  {
+                tee tee_data = _tee_pubkey.get();
+                // Start grace period for the new TEE address
+                uint64_t current_time = eosio::current_time_point().sec_since_epoch();
+                _tee_pubkey.set(tee{
+                    .key = tee_data.key,
+                    .attestation = tee_data.attestation,
+                    .updating_key = pub_key,
+                    .updating_attestation = attestation,
+                    .change_grace_threshold = current_time + TEE_ADDRESS_CHANGE_GRACE_PERIOD
+                }, self);
+            }
+        }
+
+        void apply_new_tee(name self) {
+            tee_pubkey _tee_pubkey(self, self.value);
+            check(_tee_pubkey.exists(), "tee not set, use settee");
+            uint64_t current_time = eosio::current_time_point().sec_since_epoch();
+            tee tee_data = _tee_pubkey.get();
+            if (current_time >= tee_data.change_grace_threshold) {
+                _tee_pubkey.set(tee{
+                    .key = tee_data.updating_key,
+                    .attestation = tee_data.updating_attestation,
+                    .updating_key = public_key(),
+                    .updating_attestation = {},
+                    .change_grace_threshold = 0
+                }, self);
+            } else check(false, "grace period not elapsed");
+        }
+
+        void set_origin(name self, const bytes& chain_id, const bytes& emitter, const bytes& topic_zero) {
+            check(chain_id.size() == 32, "expected 32 bytes chain_id");
+
+            check(emitter.size() == 32, "expected 32 bytes emitter");
+            check(topic_zero.size() == 32, "expected 32 bytes topic zero");
+
+            mappings_table _mappings_table(self, self.value);
+
+            auto mappings_itr = _mappings_table.find(get_mappings_key(chain_id));
+            if (mappings_itr == _mappings_table.end()) {
+                _mappings_table.emplace(self, [&](auto& row) {
+                    row.chain_id = bytes32_to_checksum256(chain_id);
+                    row.emitter = bytes32_to_checksum256(emitter);
+                    row.topic_zero = bytes32_to_checksum256(topic_zero);
+                });
+            } else {
+                _mappings_table.modify(mappings_itr, self, [&](auto& row) {
+                    row.emitter = bytes32_to_checksum256(emitter);
+                    row.topic_zero = bytes32_to_checksum256(topic_zero);
+                });
+            }
+        }
+
+        // Dual-read while the adapter is being migrated (see adapter::migrate),
+        // the settings not found in the v2 tables are read from the v1 ones
+        bool find_local_chain_id(name adapter, checksum256& out) {
+            chain_id _chain_id(adapter, adapter.value);
+            if (_chain_id.exists()) {
+                out = _chain_id.get().chain_id;
+                return true;
+            }
+
+            chain_id_v1 _chain_id_v1(adapter, adapter.value);
+            if (!_chain_id_v1.exists()) return false;
+            out = bytes32_to_checksum256(_chain_id_v1.get().chain_id);
+            return true;
+        }
+
+        bool find_mappings(name adapter, uint64_t key, mappings& out) {
+            mappings_table _mappings_table(adapter, adapter.value);
+            auto itr = _mappings_table.find(key);
+            if (itr != _mappings_table.end()) {
+                out = *itr;
+                return true;
+            }
+
+            mappings_table_v1 _mappings_table_v1(adapter, adapter.value);
+            auto itr_v1 = _mappings_table_v1.find(key);
+            if (itr_v1 == _mappings_table_v1.end()) return false;
+            out = from_legacy_mappings(*itr_v1);
+            return true;
+        }
+
+        void check_status(status s) {
+            check(s == status::ok, get_status_message(s));
+        }
+
+        // Event data decoding shared with the off-chain tools (see
+        // codec/swap_event.hpp), a truncated event past its header
+        // has a recipient length exceeding the data
+        status decode_swap_event(const bytes& event_data, pnetwork::codec::swap_event& event) {
+            switch (pnetwork::codec::decode_swap_event(event_data, event)) {
+                case pnetwork::codec::error::ok: return status::ok;
+                case pnetwork::codec::error::overflow: return status::invalid_number;
+                default: return event_data.size() <= SWAP_EVENT_HEADER_SIZE
+                    ? status::malformed_event
+                    : status::invalid_recipient_len;
+            }
+        }
+
         bool context_checks(const operation& operation, const metadata& metadata) {
             uint8_t offset = 2; // Skip protocol, version
-            bytes origin_chain_id = extract_32bytes(metadata.preimage, offset);
+            checksum256 origin_chain_id = extract_checksum256(metadata.preimage, offset);
 
-            if (origin_chain_id != operation.originChainId) {
+            if (!is_same_bytes32(origin_chain_id, operation.originChainId)) {
                 return false;
             }
 
             offset += 32;
-            bytes block_id = extract_32bytes(metadata.preimage, offset);
+            checksum256 block_id = extract_checksum256(metadata.preimage, offset);
 
             offset += 32;
-            bytes tx_id = extract_32bytes(metadata.preimage, offset);
+            checksum256 tx_id = extract_checksum256(metadata.preimage, offset);
 
-            if (block_id != operation.blockId || tx_id != operation.txId) {
+            if (!is_same_bytes32(block_id, operation.blockId) || !is_same_bytes32(tx_id, operation.txId)) {
                 return false;
             }
 
             return true;
         }
 
-        void check_authorization(name adapter, const operation& operation, const metadata& metadata, checksum256& event_id) {
-            //  Metadata preimage format:
-            //    | version | protocol | origin | blockHash | txHash | eventPayload |
-            //    |   1B    |    1B    |   32B  |    32B    |   32B  |    varlen    |
-            //    +----------- context ---------+------------- event ---------------+
-            check(context_checks(operation, metadata), "unexpected context");
-
-            chain_id _chain_id(adapter, adapter.value);
-            check(_chain_id.exists(), "local chain id singleton not set");
-            bytes local_chain_id = _chain_id.get().chain_id;
-
-            tee_pubkey _tee_pubkey(adapter, adapter.value);
-            check(_tee_pubkey.exists(), "tee singleton not set");
+        // Verifies the metadata against the adapter's PAM configuration
+        // (local chain id, TEE key and origin mappings) and extracts the
+        // event data carried in the preimage. The configuration is read
+        // from the shared registry when the adapter has one.
+        status verify_event_data(
+            name adapter,
+            const metadata& metadata,
+            checksum256& local_chain_id,
+            bytes& event_data,
+            checksum256& event_id
+        ) {
+            // Topics included, the event data length is derived from it
+            if (metadata.preimage.size() < EVENT_DATA_OFFSET) return status::invalid_preimage;
+
+            STAGE("pam.config");
+            name settings = get_settings_account(adapter);
+            if (!find_local_chain_id(settings, local_chain_id)) return status::local_chain_id_not_set;
+
+            tee_pubkey _tee_pubkey(settings, settings.value);
+            if (!_tee_pubkey.exists()) return status::tee_not_set;
             public_key tee_key = _tee_pubkey.get().key;
 
             uint128_t offset = 2;
-            bytes origin_chain_id = extract_32bytes(metadata.preimage, offset);
-            mappings_table _mappings_table(adapter, adapter.value);
-            auto itr_mappings = _mappings_table.find(get_mappings_key(origin_chain_id));
-            check(itr_mappings != _mappings_table.end(), "origin chain_id not registered");
-            bytes exp_emitter = itr_mappings->emitter;
-            bytes exp_topic_zero =  itr_mappings->topic_zero;
+            checksum256 origin_chain_id = extract_checksum256(metadata.preimage, offset);
+            mappings origin;
+            if (!find_mappings(settings, get_mappings_key(origin_chain_id), origin)) return status::origin_chain_id_not_registered;
 
+            STAGE("pam.sha256");
             event_id = sha256((const char*)metadata.preimage.data(), metadata.preimage.size());
 
+            STAGE("pam.recover_key");
+            // NOTE: a 65 bytes signature not recoverable still aborts in recover_key
+            if (metadata.signature.size() != 65) return status::malformed_signature;
             signature sig = convert_bytes_to_signature(metadata.signature);
             public_key recovered_pubkey = recover_key(event_id, sig);
-            check(recovered_pubkey == tee_key, "invalid signature");
+            if (recovered_pubkey != tee_key) return status::invalid_signature;
 
             // Event payload format
             // |  emitter  |    topic-0     |    topics-1     |    topics-2     |    topics-3     |  eventBytes  |
             // |    32B    |      32B       |       32B       |       32B       |       32B       |    varlen    |
-            offset = 0;
-            bytes event_payload(metadata.preimage.begin() + 98, metadata.preimage.end());
-            bytes emitter = extract_32bytes(event_payload, offset);
-            check(emitter == exp_emitter && !is_all_zeros(emitter), "unexpected emitter");
+            STAGE("pam.decode");
+            offset = EVENT_PAYLOAD_OFFSET;
+            checksum256 emitter = extract_checksum256(metadata.preimage, offset);
+            if (emitter != origin.emitter || is_all_zeros(emitter)) return status::unexpected_emitter;
             offset += 32;
 
-            bytes topic_zero = extract_32bytes(event_payload, offset);
-            check(topic_zero == exp_topic_zero && !is_all_zeros(topic_zero), "unexpected topic zero");
+            checksum256 topic_zero = extract_checksum256(metadata.preimage, offset);
+            if (topic_zero != origin.topic_zero || is_all_zeros(topic_zero)) return status::unexpected_topic_zero;
             offset += 32 * 4; // skip other topics
 
             // Checking the protocol id against 0x02 (EOS chains)
@@ -122,63 +361,94 @@ namespace eosio {
             //
             // We want to extract 00112233445566, so this is performed by skipping
             // the first 16 chars  and the trailing 2 chars
+            //
+            // Any other protocol (i.e. EVM chains or 0x04 for EOS chains
+            // attested in binary form) carries the event bytes as they are.
             uint8_t protocol_id = metadata.preimage[1];
-            auto start = protocol_id == 2 // EOSIO protocol
-                ? event_payload.begin() + offset + 16
-                : event_payload.begin() + offset;
+            auto decoded = pnetwork::codec::decode_event_data(
+                protocol_id,
+                metadata.preimage.data() + EVENT_DATA_OFFSET,
+                metadata.preimage.size() - EVENT_DATA_OFFSET,
+                event_data
+            );
+            if (decoded != pnetwork::codec::error::ok) return status::invalid_event_data;
+
+            return status::ok;
+        }
 
-            auto end = protocol_id == 2
-                ? event_payload.end() - 2
-                : event_payload.end();
+        // Non-asserting version of check_authorization, malformed
+        // inputs are reported with their own status as well.
+        status authorize(name adapter, const operation& operation, const metadata& metadata, checksum256& event_id) {
+            //  Metadata preimage format:
+            //    | version | protocol | origin | blockHash | txHash | eventPayload |
+            //    |   1B    |    1B    |   32B  |    32B    |   32B  |    varlen    |
+            //    +----------- context ---------+------------- event ---------------+
+            if (metadata.preimage.size() < EVENT_DATA_OFFSET) return status::invalid_preimage;
+            if (!context_checks(operation, metadata)) return status::unexpected_context;
 
-            bytes raw_data(start, end);
+            checksum256 local_chain_id;
+            bytes event_data;
+            status s = verify_event_data(adapter, metadata, local_chain_id, event_data, event_id);
+            if (s != status::ok) return s;
 
-            bytes event_data = protocol_id == 2
-                ? from_utf8_encoded_to_bytes(raw_data)
-                : raw_data;
+            STAGE("pam.match");
+            pnetwork::codec::swap_event event;
+            s = decode_swap_event(event_data, event);
+            if (s != status::ok) return s;
 
-            offset = 0;
-            bytes nonce = extract_32bytes(event_data, offset);
-            uint64_t nonce_int = bytes32_to_uint64(nonce);
+            if (operation.nonce != event.nonce) return status::invalid_nonce;
+            if (operation.token != checksum256(event.token)) return status::invalid_token_address;
 
-            check(operation.nonce == nonce_int, "nonce do not match");
-            offset += 32;
+            checksum256 dest_chain_id(event.destination_chain_id);
+            if (!is_same_bytes32(dest_chain_id, operation.destinationChainId)) return status::invalid_destination_chain_id;
+            if (local_chain_id != dest_chain_id) return status::invalid_local_chain_id;
 
-            bytes token = extract_32bytes(event_data, offset);
-            checksum256 token_hash = bytes32_to_checksum256(token);
-            check(operation.token == token_hash, "token address do not match");
-            offset += 32;
+            if (operation.amount != event.amount) return status::invalid_amount;
+            if (!is_same_bytes32(checksum256(event.sender), operation.sender)) return status::invalid_sender;
 
-            bytes dest_chain_id = extract_32bytes(event_data, offset);
-            check(operation.destinationChainId == dest_chain_id, "destination chain id does not match with the expected one");
-            check(local_chain_id == dest_chain_id, "destination chain id does not match with the current chain");
-            offset += 32;
+            // Names the name constructor would reject can't match the operation one
+            if (!pnetwork::codec::is_valid_name(event.recipient)) return status::invalid_recipient;
+            if (operation.recipient != name(event.recipient)) return status::invalid_recipient;
+            if (!is_account(operation.recipient)) return status::invalid_account;
 
-            bytes amount = extract_32bytes(event_data, offset);
-            uint128_t amount_num = bytes32_to_uint128(amount);
-            check(operation.amount == amount_num, "amount do not match");
-            offset += 32;
+            checksum256 data256 = sha256((const char*)event.data.data(), event.data.size());
+            checksum256 op_data256 = sha256((const char*)operation.data.data(), operation.data.size());
+            if (data256 != op_data256) return status::invalid_user_data;
 
-            bytes sender = extract_32bytes(event_data, offset);
-            check(operation.sender == sender, "sender do not match");
-            offset += 32;
+            return status::ok;
+        }
 
-            bytes recipient_len = extract_32bytes(event_data, offset);
-            offset += 32;
-            uint128_t recipient_len_num = bytes32_to_uint128(recipient_len);
-            const uint128_t UINT128_MAX = (uint128_t)-1;
-            check(recipient_len_num <= UINT128_MAX - offset, "overflow detected in data field");
-            bytes recipient(event_data.begin() + offset, event_data.begin() + offset + recipient_len_num);
-            name recipient_name = bytes_to_name(recipient);
-            check(operation.recipient == recipient_name, "recipient do not match");
-            check(is_account(operation.recipient), "invalid account");
-
-            offset += recipient_len_num;
-
-            bytes user_data(event_data.begin() + offset, event_data.end());
-            checksum256 data256 = sha256((const char*)user_data.data(), user_data.size());
-            checksum256 op_data256 = sha256((const char*)operation.data.data(), operation.data.size());
-            check(data256 == op_data256, "user data do not match");
+        void check_authorization(name adapter, const operation& operation, const metadata& metadata, checksum256& event_id) {
+            check_status(authorize(adapter, operation, metadata, event_id));
+        }
+
+        // Same as above, but the operation is derived from the preimage
+        // instead of being compared field by field with the given one,
+        // hence the operation is an output here.
+        void check_authorization(name adapter, const metadata& metadata, operation2& operation, checksum256& event_id) {
+            checksum256 local_chain_id;
+            bytes event_data;
+            check_status(verify_event_data(adapter, metadata, local_chain_id, event_data, event_id));
+
+            STAGE("pam.match");
+            operation.originChainId = extract_checksum256(metadata.preimage, 2);
+            operation.blockId = extract_checksum256(metadata.preimage, 34);
+            operation.txId = extract_checksum256(metadata.preimage, 66);
+
+            pnetwork::codec::swap_event event;
+            check_status(decode_swap_event(event_data, event));
+
+            operation.nonce = event.nonce;
+            operation.token = checksum256(event.token);
+            operation.destinationChainId = checksum256(event.destination_chain_id);
+            check(local_chain_id == operation.destinationChainId, get_status_message(status::invalid_local_chain_id));
+
+            operation.amount = event.amount;
+            operation.sender = bytes(event.sender.begin(), event.sender.end());
+            operation.recipient = name(event.recipient);
+            check(is_account(operation.recipient), get_status_message(status::invalid_account));
+
+            operation.data = std::move(event.data);
         }
    };
 }
\ No newline at end of file
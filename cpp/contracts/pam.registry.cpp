@@ -0,0 +1,25 @@
+#include "pam.registry.hpp"
+
+namespace eosio {
+
+void pamregistry::settee(public_key pub_key, bytes attestation) {
+   require_auth(get_self());
+   pam::set_tee(get_self(), pub_key, attestation);
+}
+
+void pamregistry::applynewtee() {
+   require_auth(get_self());
+   pam::apply_new_tee(get_self());
+}
+
+void pamregistry::setorigin(bytes chain_id, bytes emitter, bytes topic_zero) {
+   require_auth(get_self());
+   pam::set_origin(get_self(), chain_id, emitter, topic_zero);
+}
+
+void pamregistry::setchainid(bytes chain_id) {
+   require_auth(get_self());
+   pam::set_local_chain_id(get_self(), chain_id);
+}
+
+} // namespace eosio
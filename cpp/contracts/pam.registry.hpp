@@ -0,0 +1,37 @@
+#pragma once
+
+#include <eosio/eosio.hpp>
+#include <eosio/singleton.hpp>
+
+#include "pam.hpp"
+
+namespace eosio {
+   using bytes = std::vector<uint8_t>;
+
+   // PAM settings (local chain id, TEE key and origin mappings) shared
+   // by many adapters: once an adapter points here (see
+   // adapter::setregistry) check_authorization reads these tables
+   // instead of the adapter's own ones, hence a TEE rotation or a new
+   // origin is a single transaction for all of them.
+   //
+   // The tables are the same of the adapter, they are read directly
+   // by the adapters, so their layout can't change independently.
+   class [[eosio::contract("pam.registry")]] pamregistry : public contract {
+      public:
+         using contract::contract;
+
+         ACTION settee(public_key pub_key, bytes attestation);
+
+         ACTION applynewtee();
+
+         ACTION setorigin(bytes chain_id, bytes emitter, bytes topic_zero);
+
+         ACTION setchainid(bytes chain_id);
+
+      private:
+         // Define alias for ABI inclusion
+         using mappings_table = pam::mappings_table;
+         using tee_pubkey = pam::tee_pubkey;
+         using chain_id = pam::chain_id;
+   };
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+// Named stages used by the benchmarks to attribute the cost of a flow
+// (see bench/utils/stages.js): a marker starts a stage and ends the
+// previous one. Markers are built only with -DPNETWORK_STAGES (make
+// stages), release builds compile them out.
+#ifdef PNETWORK_STAGES
+#include <eosio/print.hpp>
+
+#define STAGE(name) eosio::print("#stage:" name "\n")
+#else
+#define STAGE(name) ((void)0)
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <eosio/asset.hpp>
+#include <eosio/eosio.hpp>
+
+namespace eosio {
+   constexpr uint8_t lockbox_route_wrap = 0;
+   constexpr uint8_t lockbox_route_unwrap = 1;
+
+   // NOTE: each registered pair has two routes, one scoped by
+   // the token contract (wrap) and one scoped by the xERC20
+   // contract (unwrap), so the incoming transfer resolves to its
+   // pair with a single exact lookup on (first receiver, symbol code).
+   TABLE lockbox_route_table {
+      symbol   sym;
+      uint8_t  direction;
+      name     counterpart;
+      symbol   counterpart_symbol;
+      int64_t  total; // cumulative deposited (wrap) or released (unwrap)
+
+      uint64_t primary_key() const { return sym.code().raw(); }
+   };
+}
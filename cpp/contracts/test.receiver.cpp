@@ -2,14 +2,25 @@
 
 namespace eosio {
    void testreceiver::onreceive(const name& caller, const operation& operation, const metadata& metadata) {
-      results _results(get_self(), get_self().value);
+      add_result(operation.data);
+   }
+
+   // The user data is at the end of the preimage's event payload
+   void testreceiver::onreceive2(const name& caller, const metadata& metadata) {
+      pnetwork::codec::preimage preimage;
+      pnetwork::codec::swap_event event;
+      check(pnetwork::codec::parse_preimage(metadata.preimage, preimage) == pnetwork::codec::error::ok, "invalid preimage");
+      check(pnetwork::codec::decode_swap_event(preimage.event_data, event) == pnetwork::codec::error::ok, "invalid event");
 
-      auto itr = _results.end();
-      auto id = itr == _results.begin() ? 0 : itr->id + 1;
+      add_result(event.data);
+   }
+
+   void testreceiver::add_result(const bytes& data) {
+      results _results(get_self(), get_self().value);
 
       _results.emplace(get_self(), [&](auto& r) {
-         r.id = id;
-         r.data = operation.data;
+         r.id = _results.available_primary_key();
+         r.data = data;
       });
    }
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 
 #include "operation.hpp"
 #include "metadata.hpp"
+#include "../codec/preimage.hpp"
+#include "../codec/swap_event.hpp"
 
 namespace eosio {
    using std::string;
@@ -20,6 +22,11 @@ namespace eosio {
          [[eosio::on_notify("*::settle")]]
          void onreceive(const name& caller, const operation& operation, const metadata& metadata);
 
+         // settle2 notifies the recipient with its own action name,
+         // so the handler above is not called for it
+         [[eosio::on_notify("*::settle2")]]
+         void onreceive2(const name& caller, const metadata& metadata);
+
       private:
 
       struct [[eosio::table]] result_table {
@@ -30,5 +37,7 @@ namespace eosio {
       };
 
       typedef eosio::multi_index<"results"_n, result_table> results;
+
+      void add_result(const bytes& data);
    };
 }
@@ -4,6 +4,7 @@
 #include <eosio/transaction.hpp>
 #include "operation.hpp"
 #include "metadata.hpp"
+#include "../codec/bytes.hpp"
 
 #include <string>
 
@@ -20,25 +21,6 @@ namespace eosio {
          && s.find_first_not_of(allowed_chars, 2) == string::npos;
    }
 
-   // https://github.com/stableex/sx.curve/blob/f26604725be2d1faea1eb0a1c44e0266fac37875/include/sx.utils/utils.hpp#L129
-   static vector<string> split(const string str, const string delim) {
-      vector<string> tokens;
-      if (str.size() == 0) return tokens;
-
-      size_t prev = 0, pos = 0;
-      do {
-         pos = str.find(delim, prev);
-         if (pos == string::npos)
-            pos = str.length();
-         string token = str.substr(prev, pos - prev);
-         if (token.length() > 0)
-            tokens.push_back(token);
-         prev = pos + delim.length();
-      } while (pos < str.length() && prev < str.length());
-
-      return tokens;
-   }
-
    bytes hex_to_bytes(const string &hex) {
       bytes bytes;
       for (unsigned int i = 0; i < hex.length(); i += 2) {
@@ -148,6 +130,15 @@ namespace eosio {
       return _data;
    }
 
+   // Same as above without the heap allocation, for values
+   // compared as 32 bytes blobs
+   checksum256 extract_checksum256(const bytes& data, uint128_t offset) {
+      check(data.size() > offset + 32, "cannot extract 32 bytes: offset greater than data length");
+      std::array<uint8_t, 32> _data;
+      std::copy(data.begin() + offset, data.begin() + offset + 32, _data.begin());
+      return checksum256(_data);
+   }
+
    signature convert_bytes_to_signature(const bytes& input_bytes) {
       check(input_bytes.size() == 65, "signature must be exactly 65 bytes");
       std::array<char, 65> sig_data;
@@ -167,48 +158,51 @@ namespace eosio {
          (static_cast<uint64_t>(chain_id[31]));
    }
 
+   uint64_t get_mappings_key(const checksum256& chain_id) {
+      auto data = chain_id.extract_as_byte_array();
+      uint64_t key = 0;
+      for (size_t i = 24; i < 32; i++) {
+         key = (key << 8) | data[i];
+      }
+      return key;
+   }
+
+   bool is_all_zeros(const checksum256& value) {
+      return value == checksum256();
+   }
+
    bool is_all_zeros(const bytes& emitter) {
       return std::all_of(emitter.begin(), emitter.end(), [](uint8_t byte) {
          return byte == 0x00;
       });
    }
 
+   // Same rule of the off-chain decoding (see codec/bytes.hpp), numbers
+   // are rejected unless all the bytes above their width are zero
    uint128_t bytes32_to_uint128(const bytes& data) {
       check(data.size() == 32, "input must be 32 bytes long.");
-      // Check for overflow (first 16 bytes must be 0, bigger numbers not supported)
-      for (size_t i = 0; i < 16; ++i) {
-         if (data[i] != 0) {
-               check(false, "number exceeds 128 bits.");
-         }
-      }
-
       uint128_t result = 0;
-      for (size_t i = 16; i < 32; ++i) {
-         result <<= 8;
-         result |= data[i];
-      }
-
+      auto decoded = pnetwork::codec::from_bytes32(pnetwork::codec::read_bytes32(data.data()), result);
+      check(decoded == pnetwork::codec::error::ok, "number exceeds 128 bits.");
       return result;
    }
 
    uint64_t bytes32_to_uint64(const bytes& data) {
       check(data.size() == 32, "The input must be 32 bytes long.");
-      // Check for overflow (first 8 bytes must be 0, bigger numbers not supported)
-      for (size_t i = 0; i < 8; ++i) {
-         if (data[i] != 0) {
-               check(false, "number exceeds 64 bits.");
-         }
-      }
-
       uint64_t result = 0;
-      for (size_t i = 8; i < 32; ++i) {
-         result <<= 8;
-         result |= data[i];
-      }
-
+      auto decoded = pnetwork::codec::from_bytes32(pnetwork::codec::read_bytes32(data.data()), result);
+      check(decoded == pnetwork::codec::error::ok, "number exceeds 64 bits.");
       return result;
    }
 
+   // Compares a fixed width value with its variable length
+   // form without copying it, false when the size differs
+   bool is_same_bytes32(const checksum256& value, const bytes& data) {
+      if (data.size() != 32) return false;
+      auto array = value.extract_as_byte_array();
+      return std::equal(array.begin(), array.end(), data.begin());
+   }
+
    checksum256 bytes32_to_checksum256(const bytes& data) {
       check(data.size() == 32, "input must be 32 bytes long.");
       std::array<uint8_t, 32> byte_array;
@@ -216,42 +210,20 @@ namespace eosio {
       return checksum256(byte_array);
    }
 
-   name bytes_to_name(const bytes& data) {
-      uint8_t length = std::min(static_cast<uint8_t>(data.size()), static_cast<uint8_t>(8));
-      std::string name_str;
-      for (uint8_t byte : data) {
-         char eosio_char = static_cast<char>(byte);
-         name_str += eosio_char;
-      }
-      name name_value(name_str);
-      return name_value;
-   }
-
-   uint8_t from_hex_char_to_uint8(uint8_t x) {
-      if ((x >= 97) && (x <= 102)) { // [a, b, c, ..., f]
-            x -= 87;
-      } else if ((x >= 65) && (x <= 70)) { // [A, B, C, ..., F]
-            x -= 55;
-      } else if ((x >= 48) && (x <= 57)) { // [0, 1, 2, ... ,9]
-            x -= 48;
-      }
-
-      return x;
-   }
-
-   bytes from_utf8_encoded_to_bytes(const bytes &utf8_encoded) {
-      check(utf8_encoded.size() % 2 == 0, "invalid utf-8 encoded string");
-
-      bytes x(utf8_encoded.size() / 2, 0); // fill it with zeros
-
-      uint64_t k = 0;
-      uint8_t b1, b2;
-      for (uint64_t i = 0; i < utf8_encoded.size(); i += 2) {
-            b1 = from_hex_char_to_uint8(utf8_encoded[i]);
-            b2 = from_hex_char_to_uint8(utf8_encoded[i + 1]);
-            x[k++] = b1 * 16 + b2;
-      }
-
-      return x;
+   // The 32 bytes fields are expected to be already checked
+   // against the preimage (see pam::authorize)
+   operation2 to_operation2(const operation& op) {
+      return operation2 {
+         .blockId = bytes32_to_checksum256(op.blockId),
+         .txId = bytes32_to_checksum256(op.txId),
+         .nonce = op.nonce,
+         .token = op.token,
+         .originChainId = bytes32_to_checksum256(op.originChainId),
+         .destinationChainId = bytes32_to_checksum256(op.destinationChainId),
+         .amount = op.amount,
+         .sender = op.sender,
+         .recipient = op.recipient,
+         .data = op.data
+      };
    }
 }
\ No newline at end of file
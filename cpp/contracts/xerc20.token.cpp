@@ -20,6 +20,7 @@ void xtoken::create( const name&   issuer,
        s.supply.symbol = maximum_supply.symbol;
        s.max_supply    = maximum_supply;
        s.issuer        = issuer;
+       s.frozen_flags.emplace( true ); // no account frozen before the flags
     });
 }
 
@@ -35,24 +36,8 @@ void xtoken::mint( const name& caller, const name& to, const asset& quantity, co
     check( existing != statstable.end(), "token with symbol does not exist, create token before issue" );
     const auto& st = *existing;
 
-    name lockbox;
-    lockbox_singleton _lockbox( get_self(), get_self().value );
-    if (_lockbox.exists()) lockbox = _lockbox.get();
-    bridges bridgestable( get_self(), get_self().value );
-    auto idx = bridgestable.get_index<name("bysymbol")>();
-    auto itr = idx.lower_bound( quantity.symbol.code().raw() );
-    while ( itr != idx.end() && itr->account != caller ) { itr++; }
-
-    check( itr != idx.end() || caller == lockbox, "only lockbox or supported bridge can mint" );
-
-    if (caller != lockbox) {
-      auto bridge = *itr;
-      auto current_limit = minting_current_limit_of(bridge);
-      check(quantity <= current_limit, "xerc20_assert: not high enough limits");
-      use_minter_limits(bridge, quantity);
-
-      bridgestable.modify(*itr, same_payer, [&](auto& r) { r = bridge; });
-    }
+    STAGE("xtoken.mint.limits");
+    use_minting_limit( caller, sym, quantity.amount );
 
     require_auth( caller );
     check( quantity.is_valid(), "invalid quantity" );
@@ -60,15 +45,138 @@ void xtoken::mint( const name& caller, const name& to, const asset& quantity, co
     check( quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
     check( quantity.amount <= st.max_supply.amount - st.supply.amount, "quantity exceeds available supply");
 
+    STAGE("xtoken.mint.supply");
     statstable.modify( st, same_payer, [&]( auto& s ) {
        s.supply += quantity;
+       record_checkpoint( s, quantity.amount, 0 );
     });
 
+    STAGE("xtoken.mint.balance");
     add_balance( to, quantity, caller );
 
     require_recipient(to);
 }
 
+void xtoken::mintbatch( const name& caller, const vector<mint_entry>& entries )
+{
+    require_auth(caller);
+    check( !entries.empty(), "nothing to mint" );
+    auto sym = entries[0].quantity.symbol;
+    check( sym.is_valid(), "invalid symbol name" );
+
+    stats statstable( get_self(), sym.code().raw() );
+    auto existing = statstable.find( sym.code().raw() );
+    check( existing != statstable.end(), "token with symbol does not exist, create token before issue" );
+    const auto& st = *existing;
+
+    int64_t total = 0;
+    for (const auto& entry : entries) {
+       check( entry.memo.size() <= 256, "memo has more than 256 bytes" );
+       check( entry.quantity.is_valid(), "invalid quantity" );
+       check( entry.quantity.amount > 0, "must issue positive quantity" );
+       check( entry.quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
+       check( entry.quantity.amount <= st.max_supply.amount - st.supply.amount - total, "quantity exceeds available supply");
+       total += entry.quantity.amount;
+    }
+
+    // Limits and supply are checked and updated once for the whole batch
+    use_minting_limit( caller, sym, total );
+
+    statstable.modify( st, same_payer, [&]( auto& s ) {
+       s.supply.amount += total;
+       record_checkpoint( s, total, 0 );
+    });
+
+    for (const auto& entry : entries) {
+       add_balance( entry.to, entry.quantity, caller );
+       require_recipient( entry.to );
+    }
+}
+
+// Called within the stats row update, so the checkpoint
+// (and the frozen flags state) is stored with the same write
+void xtoken::record_checkpoint(currency_stats& stats, int64_t minted, int64_t burned) {
+   sync_frozen_flags(stats);
+   if (!stats.ring.has_value()) return;
+
+   auto& ring = stats.ring.value();
+   ring.minted += minted;
+   ring.burned += burned;
+
+   supply_checkpoint checkpoint {
+      .block = current_block_time().slot,
+      .supply = stats.supply.amount,
+      .minted = ring.minted,
+      .burned = ring.burned
+   };
+
+   if (ring.interval == 0) {
+      // One checkpoint per block, holding the block final state
+      if (!ring.checkpoints.empty()) {
+         auto last = (ring.head + ring.size - 1) % ring.size;
+         if (ring.checkpoints.size() < ring.size) last = ring.checkpoints.size() - 1;
+         if (ring.checkpoints[last].block == checkpoint.block) {
+            ring.checkpoints[last] = checkpoint;
+            return;
+         }
+      }
+   } else if (++ring.ops < ring.interval) {
+      return;
+   }
+
+   ring.ops = 0;
+   if (ring.checkpoints.size() < ring.size) {
+      ring.checkpoints.push_back(checkpoint);
+   } else {
+      ring.checkpoints[ring.head] = checkpoint;
+      ring.head = (ring.head + 1) % ring.size;
+   }
+}
+
+void xtoken::use_burning_limit( const name& caller, const symbol& sym, int64_t amount )
+{
+   lockbox_singleton _lockbox( get_self(), get_self().value );
+   auto lockbox = _lockbox.get_or_default(name(0));
+   limits limitstable( get_self(), sym.code().raw() );
+   auto itr = find_limits( limitstable, caller, sym );
+
+   check( itr != limitstable.end() || caller == lockbox, "only lockbox or supported bridge can mint" );
+
+   if (caller != lockbox) {
+      auto block_time = now();
+      check(amount <= get_current_limit(itr->burning, block_time), "xerc20_assert: not hight enough limits");
+
+      // The row is written anyway by use_limit, so keeping the
+      // counter regardless of the checkpoints adds no table write
+      limitstable.modify(itr, same_payer, [&](auto& r) {
+         use_limit(r.burning, amount, block_time);
+         r.burned += amount;
+      });
+   }
+}
+
+void xtoken::use_minting_limit( const name& caller, const symbol& sym, int64_t amount )
+{
+    name lockbox;
+    lockbox_singleton _lockbox( get_self(), get_self().value );
+    if (_lockbox.exists()) lockbox = _lockbox.get();
+    limits limitstable( get_self(), sym.code().raw() );
+    auto itr = find_limits( limitstable, caller, sym );
+
+    check( itr != limitstable.end() || caller == lockbox, "only lockbox or supported bridge can mint" );
+
+    if (caller != lockbox) {
+      auto block_time = now();
+      check(amount <= get_current_limit(itr->minting, block_time), "xerc20_assert: not high enough limits");
+
+      // Same as use_burning_limit
+      limitstable.modify(itr, same_payer, [&](auto& r) {
+         use_limit(r.minting, amount, block_time);
+         r.minted += amount;
+      });
+    }
+}
+
 void xtoken::burn( const name& caller, const asset& quantity, const string& memo )
 {
    require_auth(caller);
@@ -81,23 +189,8 @@ void xtoken::burn( const name& caller, const asset& quantity, const string& memo
    check( existing != statstable.end(), "token with symbol does not exist" );
    const auto& st = *existing;
 
-   lockbox_singleton _lockbox( get_self(), get_self().value );
-   auto lockbox = _lockbox.get_or_default(name(0));
-   bridges bridgestable( get_self(), get_self().value );
-   auto idx = bridgestable.get_index<name("bysymbol")>();
-   auto itr = idx.lower_bound( quantity.symbol.code().raw() );
-   while ( itr != idx.end() && itr->account != caller ) { itr++; }
-
-   check( itr != idx.end() || caller == lockbox, "only lockbox or supported bridge can mint" );
-
-   if (caller != lockbox) {
-      auto bridge = *itr;
-      auto current_limit = burning_current_limit_of(bridge);
-      check(quantity <= current_limit, "xerc20_assert: not hight enough limits");
-      use_burner_limits(bridge, quantity);
-
-      bridgestable.modify(*itr, same_payer, [&](auto& r) { r = bridge; });
-   }
+   STAGE("xtoken.burn.limits");
+   use_burning_limit( caller, sym, quantity.amount );
 
    require_auth( caller );
    check( quantity.is_valid(), "invalid quantity" );
@@ -105,15 +198,76 @@ void xtoken::burn( const name& caller, const asset& quantity, const string& memo
 
    check( quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
 
+   STAGE("xtoken.burn.supply");
    statstable.modify( st, same_payer, [&]( auto& s ) {
       s.supply -= quantity;
+      record_checkpoint( s, 0, quantity.amount );
    });
 
 
+   STAGE("xtoken.burn.balance");
    sub_balance( caller, quantity );
 
 }
 
+void xtoken::burnfee( const name& caller, const asset& quantity, const name& fee_recipient, const asset& fee )
+{
+   require_auth(caller);
+   auto sym = quantity.symbol;
+   check( sym.is_valid(), "invalid symbol name" );
+
+   stats statstable( get_self(), sym.code().raw() );
+   auto existing = statstable.find( sym.code().raw() );
+   check( existing != statstable.end(), "token with symbol does not exist" );
+   const auto& st = *existing;
+
+   check( quantity.is_valid(), "invalid quantity" );
+   check( fee.is_valid(), "invalid fee" );
+   check( quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
+   check( fee.symbol == quantity.symbol, "fee symbol mismatch" );
+   check( fee.amount >= 0, "fee must not be negative" );
+   check( quantity.amount > fee.amount, "must burn positive quantity" );
+   check( caller != fee_recipient, "cannot transfer to self" );
+   check( is_account( fee_recipient ), "to account does not exist" );
+
+   // Only the net amount is burnt, hence consumes the limits
+   asset net_amount = quantity - fee;
+   use_burning_limit( caller, sym, net_amount.amount );
+
+   statstable.modify( st, same_payer, [&]( auto& s ) {
+      s.supply -= net_amount;
+      record_checkpoint( s, 0, net_amount.amount );
+   });
+
+   // The caller balance is debited once for both the fee and the burnt amount
+   accounts from_acnts( get_self(), caller.value );
+   const auto& from = from_acnts.get( sym.code().raw(), "no balance object found" );
+   check( !is_frozen(st, from, caller), "from account is frozen" );
+   check( from.balance.amount >= quantity.amount, "overdrawn balance" );
+
+   from_acnts.modify( from, caller, [&]( auto& a ) {
+         a.balance -= quantity;
+      });
+
+   if( fee.amount == 0 ) return;
+
+   accounts to_acnts( get_self(), fee_recipient.value );
+   auto to = to_acnts.find( sym.code().raw() );
+   check( to != to_acnts.end() ? !is_frozen(st, *to, fee_recipient) : !is_frozen(fee_recipient), "to account is frozen" );
+
+   if( to == to_acnts.end() ) {
+      to_acnts.emplace( caller, [&]( auto& a ){
+        a.balance = fee;
+      });
+   } else {
+      to_acnts.modify( to, same_payer, [&]( auto& a ) {
+        a.balance += fee;
+      });
+   }
+
+   require_recipient( fee_recipient );
+}
+
 bool xtoken::is_frozen(const name& account) {
    frozens _frozens(get_self(), get_self().value);
    const auto& itr = _frozens.find(account.value);
@@ -121,19 +275,49 @@ bool xtoken::is_frozen(const name& account) {
    return itr != _frozens.end();
 }
 
+// Accounts frozen before the flag was introduced are found in
+// frozensacc only, until their flags are set by migrate. The stats
+// row (already read by the callers) tells whether that can be the
+// case, so the flag alone is checked otherwise.
+bool xtoken::is_frozen(const currency_stats& stats, const account& row, const name& owner) {
+   if (row.is_frozen()) return true;
+
+   return !stats.frozen_flags.value_or(false) && is_frozen(owner);
+}
+
+// Stats rows created before the flags are marked once the
+// migration has flagged all the accounts in frozensacc
+void xtoken::sync_frozen_flags(currency_stats& stats) {
+   if (stats.frozen_flags.value_or(false)) return;
+   if (!migration::is_completed(get_self(), MIGRATION_STEP_FROZEN)) return;
+
+   stats.frozen_flags.emplace(true);
+}
+
 void xtoken::transfer( const name&    from,
                       const name&    to,
                       const asset&   quantity,
                       const string&  memo )
 {
-    check(!is_frozen(from), "from account is frozen");
-    check(!is_frozen(to), "to account is frozen");
     check( from != to, "cannot transfer to self" );
-    require_auth( from );
-    check( is_account( to ), "to account does not exist");
     auto sym = quantity.symbol.code();
+
+    // The frozen flag lives in the balance rows, so checking it
+    // costs no more reads than the balance update itself, the
+    // frozensacc table is read only when creating a new row (or
+    // for the stats rows not marked yet, see is_frozen)
     stats statstable( get_self(), sym.raw() );
     const auto& st = statstable.get( sym.raw() );
+    accounts from_acnts( get_self(), from.value );
+    accounts to_acnts( get_self(), to.value );
+    auto from_itr = from_acnts.find( sym.raw() );
+    auto to_itr = to_acnts.find( sym.raw() );
+
+    check( from_itr == from_acnts.end() || !is_frozen(st, *from_itr, from), "from account is frozen" );
+    check( to_itr != to_acnts.end() ? !is_frozen(st, *to_itr, to) : !is_frozen(to), "to account is frozen" );
+
+    require_auth( from );
+    check( is_account( to ), "to account does not exist");
 
     require_recipient( from );
     require_recipient( to );
@@ -145,9 +329,22 @@ void xtoken::transfer( const name&    from,
 
     auto payer = has_auth( to ) ? to : from;
 
-    sub_balance( from, quantity );
+    check( from_itr != from_acnts.end(), "no balance object found" );
+    check( from_itr->balance.amount >= quantity.amount, "overdrawn balance" );
 
-    add_balance( to, quantity, payer );
+    from_acnts.modify( from_itr, from, [&]( auto& a ) {
+         a.balance -= quantity;
+      });
+
+    if( to_itr == to_acnts.end() ) {
+       to_acnts.emplace( payer, [&]( auto& a ){
+         a.balance = quantity;
+       });
+    } else {
+       to_acnts.modify( to_itr, same_payer, [&]( auto& a ) {
+         a.balance += quantity;
+       });
+    }
 }
 
 void xtoken::sub_balance( const name& owner, const asset& value ) {
@@ -166,8 +363,10 @@ void xtoken::add_balance( const name& owner, const asset& value, const name& ram
    accounts to_acnts( get_self(), owner.value );
    auto to = to_acnts.find( value.symbol.code().raw() );
    if( to == to_acnts.end() ) {
+      bool frozen = is_frozen( owner );
       to_acnts.emplace( ram_payer, [&]( auto& a ){
         a.balance = value;
+        if( frozen ) a.frozen.emplace( true );
       });
    } else {
       to_acnts.modify( to, same_payer, [&]( auto& a ) {
@@ -191,8 +390,10 @@ void xtoken::open( const name& owner, const symbol& symbol, const name& ram_paye
    accounts acnts( get_self(), owner.value );
    auto it = acnts.find( sym_code_raw );
    if( it == acnts.end() ) {
+      bool frozen = is_frozen( owner );
       acnts.emplace( ram_payer, [&]( auto& a ){
         a.balance = asset{0, symbol};
+        if( frozen ) a.frozen.emplace( true );
       });
    }
 }
@@ -213,6 +414,80 @@ void xtoken::setlockbox(const name& account) {
    lockbox.set(account, get_self());
 }
 
+void xtoken::setwrap(const name& token, const symbol& token_symbol, const symbol& symbol) {
+   require_auth(get_self());
+   check(is_account(token), "token account does not exist");
+   check(token != get_self(), "invalid underlying token");
+   check(token_symbol.precision() == symbol.precision(), "symbol precision mismatch");
+
+   stats statstable( get_self(), symbol.code().raw() );
+   const auto& st = statstable.get( symbol.code().raw(), "symbol does not exist" );
+   check( st.supply.symbol == symbol, "symbol precision mismatch" );
+
+   wrap_singleton wrap(get_self(), get_self().value);
+   wrap.set({ .token = token, .token_symbol = token_symbol, .sym = symbol }, get_self());
+}
+
+// Wraps the underlying token received, minting in the same action
+void xtoken::ontransfer(const name& from, const name& to, const asset& quantity, const string& memo) {
+   if (from == get_self() || to != get_self()) return;
+
+   wrap_singleton wrap(get_self(), get_self().value);
+   if (!wrap.exists()) return;
+
+   auto config = wrap.get();
+   if (get_first_receiver() != config.token) return;
+
+   check( quantity.symbol == config.token_symbol, "invalid symbol" );
+   check( quantity.amount > 0, "invalid amount" );
+
+   auto xquantity = asset(quantity.amount, config.sym);
+   stats statstable( get_self(), config.sym.code().raw() );
+   const auto& st = statstable.get( config.sym.code().raw() );
+   check( xquantity.amount <= st.max_supply.amount - st.supply.amount, "quantity exceeds available supply");
+
+   statstable.modify( st, same_payer, [&]( auto& s ) {
+      s.supply += xquantity;
+      record_checkpoint( s, xquantity.amount, 0 );
+   });
+
+   add_balance( from, xquantity, get_self() );
+}
+
+// Burns the wrapped token releasing the underlying collateral
+void xtoken::unwrap(const name& owner, const asset& quantity) {
+   require_auth(owner);
+
+   wrap_singleton wrap(get_self(), get_self().value);
+   check(wrap.exists(), "wrap not enabled");
+   auto config = wrap.get();
+
+   check( quantity.is_valid(), "invalid quantity" );
+   check( quantity.amount > 0, "must unwrap positive quantity" );
+   check( quantity.symbol == config.sym, "symbol precision mismatch" );
+
+   stats statstable( get_self(), config.sym.code().raw() );
+   const auto& st = statstable.get( config.sym.code().raw() );
+
+   statstable.modify( st, same_payer, [&]( auto& s ) {
+      s.supply -= quantity;
+      record_checkpoint( s, 0, quantity.amount );
+   });
+
+   // Same as a transfer to the lockbox, frozen accounts can't unwrap
+   accounts from_acnts( get_self(), owner.value );
+   const auto& from = from_acnts.get( quantity.symbol.code().raw(), "no balance object found" );
+   check( !is_frozen(st, from, owner), "from account is frozen" );
+   check( from.balance.amount >= quantity.amount, "overdrawn balance" );
+
+   from_acnts.modify( from, owner, [&]( auto& a ) {
+         a.balance -= quantity;
+      });
+
+   action_transfer _transfer(config.token, { get_self(), "active"_n });
+   _transfer.send(get_self(), owner, asset(quantity.amount, config.token_symbol), string("unwrap"));
+}
+
 void xtoken::setlimits( const name& account, const asset& minting_limit, const asset& burning_limit ) {
    require_auth( get_self() );
    check( minting_limit.symbol == burning_limit.symbol, "minting and burning limits symbol does not match" );
@@ -228,124 +503,302 @@ void xtoken::setlimits( const name& account, const asset& minting_limit, const a
    const auto& st = *existing_symbol;
    check( minting_limit.symbol == st.supply.symbol, "symbol precision mismatch");
 
-   bridges bridgestable( get_self(), get_self().value );
-   auto idx = bridgestable.get_index<name("bysymbol")>();
-   auto itr = idx.lower_bound(symbol_code);
-   while ( itr != idx.end() && itr->account != account ) { itr++; }
-
-   bridge_model bridge = itr != idx.end() ? *itr : get_empty_bridge_model(account, minting_limit.symbol);
-   change_minter_limit(bridge, minting_limit);
-   change_burner_limit(bridge, burning_limit);
+   limits limitstable( get_self(), symbol_code );
+   auto itr = find_limits( limitstable, account, minting_limit.symbol );
+   auto block_time = now();
 
-   if (itr == idx.end()) {
+   if (itr == limitstable.end()) {
       // Insert a new bridge limits
-      bridgestable.emplace(get_self(), [&](auto& row) {
-         row = bridge;
+      limitstable.emplace(get_self(), [&](auto& row) {
+         row.account = account;
+         row.minting = {};
+         row.burning = {};
+         row.minted = 0;
+         row.burned = 0;
+         change_limit(row.minting, minting_limit.amount, block_time);
+         change_limit(row.burning, burning_limit.amount, block_time);
       });
    } else {
       // Modify the existing bridge limits
-      bridgestable.modify(*itr, same_payer, [&](auto& row) {
-         row = bridge;
+      limitstable.modify(itr, same_payer, [&](auto& row) {
+         change_limit(row.minting, minting_limit.amount, block_time);
+         change_limit(row.burning, burning_limit.amount, block_time);
       });
    }
 }
 
-xtoken::bridge_model xtoken::get_empty_bridge_model(const name& account, const symbol& symbol) {
-   asset zeroedAsset = asset(0, symbol);
-   bridge_model b = {
-      .account = account,
-      .minting_timestamp = 0,
-      .minting_rate = 0,
-      .minting_current_limit = zeroedAsset,
-      .minting_max_limit = zeroedAsset,
-      .burning_timestamp = 0,
-      .burning_rate = 0,
-      .burning_current_limit = zeroedAsset,
-      .burning_max_limit = zeroedAsset
-   };
-   return b;
+migration::cursor xtoken::migrate(uint32_t max_rows) {
+   require_auth( get_self() );
+
+   auto block_time = now();
+
+   return migration::run(get_self(), max_rows,
+      // bridges -> limits (MIGRATION_STEP_BRIDGES)
+      [&](uint32_t budget) {
+         bridges bridgestable( get_self(), get_self().value );
+         return migration::drain(bridgestable, budget, [&](const auto& legacy) {
+            limits limitstable( get_self(), legacy.minting_max_limit.symbol.code().raw() );
+            check( limitstable.find(legacy.account.value) == limitstable.end(), "bridge already migrated" );
+
+            limitstable.emplace(get_self(), [&](auto& row) {
+               row = from_legacy_bridge(legacy, block_time);
+            });
+         });
+      },
+      // frozensacc -> account::frozen (MIGRATION_STEP_FROZEN)
+      [&](uint32_t budget) {
+         frozens _frozens( get_self(), get_self().value );
+         return migration::scan(get_self(), _frozens, budget, [&](const auto& row) {
+            set_frozen_flag(row.account, true);
+         });
+      }
+   );
 }
 
-asset xtoken::calculate_new_current_limit(const asset& limit, const asset& old_limit, const asset& current_limit) {
-   uint64_t difference = 0;
-   uint64_t new_current_limit = 0;
-   if (old_limit.amount > limit.amount) {
-      difference = old_limit.amount - limit.amount;
-      new_current_limit = current_limit.amount > difference ? current_limit.amount - difference : 0;
-   } else {
-      difference = limit.amount - old_limit.amount;
-      new_current_limit = current_limit.amount + difference;
+vector<asset> xtoken::getbalances(const symbol_code& sym_code, const vector<name>& owners) {
+   stats statstable( get_self(), sym_code.raw() );
+   const auto& st = statstable.get( sym_code.raw(), "symbol does not exist" );
+
+   vector<asset> balances;
+   balances.reserve(owners.size());
+   for (const auto& owner : owners) {
+      accounts acnts( get_self(), owner.value );
+      auto itr = acnts.find( sym_code.raw() );
+      balances.push_back(itr != acnts.end() ? itr->balance : asset(0, st.supply.symbol));
    }
 
-   return asset(new_current_limit, limit.symbol);
+   return balances;
 }
 
-asset xtoken::get_current_limit(const asset& current_limit, const asset& max_limit, const uint64_t timestamp, const uint64_t rate_per_second) {
-   asset limit = current_limit;
+vector<xtoken::bridge_headroom> xtoken::getheadroom(const symbol_code& sym_code) {
+   stats statstable( get_self(), sym_code.raw() );
+   const auto& st = statstable.get( sym_code.raw(), "symbol does not exist" );
+   auto sym = st.supply.symbol;
+   auto block_time = now();
+
+   vector<bridge_headroom> headroom;
+   limits limitstable( get_self(), sym_code.raw() );
+   for (auto itr = limitstable.begin(); itr != limitstable.end(); itr++) {
+      headroom.push_back({
+         .account = itr->account,
+         .minting = asset(get_current_limit(itr->minting, block_time), sym),
+         .burning = asset(get_current_limit(itr->burning, block_time), sym),
+         .minting_max = asset(itr->minting.max, sym),
+         .burning_max = asset(itr->burning.max, sym)
+      });
+   }
 
-   uint64_t block_timestamp = current_block_time()
-      .to_time_point()
-      .sec_since_epoch();
+   // Bridges not migrated yet
+   if (migration::is_completed(get_self(), MIGRATION_STEP_BRIDGES)) return headroom;
 
-   if (limit == max_limit) {
-      limit = max_limit;
-   } else if (timestamp + DURATION <= block_timestamp) {
-      limit = max_limit;
-   } else if (timestamp + DURATION > block_timestamp) {
-      uint64_t time_passed = block_timestamp - timestamp;
-      asset calculated_limit = limit + asset(time_passed * rate_per_second, limit.symbol);
-      limit = calculated_limit > max_limit ? max_limit : calculated_limit;
+   bridges bridgestable( get_self(), get_self().value );
+   auto bysymbol = bridgestable.get_index<"bysymbol"_n>();
+   for (auto itr = bysymbol.lower_bound(sym_code.raw()); itr != bysymbol.end() && itr->secondary_key() == sym_code.raw(); itr++) {
+      auto legacy = from_legacy_bridge(*itr, block_time);
+      headroom.push_back({
+         .account = legacy.account,
+         .minting = asset(legacy.minting.current, sym),
+         .burning = asset(legacy.burning.current, sym),
+         .minting_max = asset(legacy.minting.max, sym),
+         .burning_max = asset(legacy.burning.max, sym)
+      });
    }
 
-   return limit;
+   return headroom;
 }
 
-asset xtoken::minting_current_limit_of(bridge_model& bridge) {
-   return get_current_limit(
-      bridge.minting_current_limit,
-      bridge.minting_max_limit,
-      bridge.minting_timestamp,
-      bridge.minting_rate
-   );
+void xtoken::setcheckpts(const symbol_code& sym_code, uint16_t size, uint32_t interval) {
+   require_auth( get_self() );
+   check( size <= MAX_CHECKPOINTS, "too many checkpoints" );
+
+   stats statstable( get_self(), sym_code.raw() );
+   const auto& st = statstable.get( sym_code.raw(), "symbol does not exist" );
+
+   statstable.modify( st, same_payer, [&]( auto& s ) {
+      if (size == 0) {
+         s.ring.reset();
+         return;
+      }
+
+      // Extensions are serialized in order, the ring comes after
+      if (!s.frozen_flags.has_value()) s.frozen_flags.emplace(false);
+
+      // Cumulative counters survive a resize, the
+      // checkpoints taken so far are dropped
+      supply_ring ring = s.ring.value_or(supply_ring{
+         .size = 0,
+         .interval = 0,
+         .ops = 0,
+         .head = 0,
+         .minted = 0,
+         .burned = 0,
+         .checkpoints = {}
+      });
+      ring.size = size;
+      ring.interval = interval;
+      ring.ops = 0;
+      ring.head = 0;
+      ring.checkpoints.clear();
+      ring.checkpoints.reserve(size);
+      s.ring.emplace(ring);
+   });
 }
 
-asset xtoken::burning_current_limit_of(bridge_model& bridge) {
-   return get_current_limit(
-      bridge.burning_current_limit,
-      bridge.burning_max_limit,
-      bridge.burning_timestamp,
-      bridge.burning_rate
-   );
+xtoken::supply_checkpoints xtoken::getcheckpts(const symbol_code& sym_code) {
+   stats statstable( get_self(), sym_code.raw() );
+   const auto& st = statstable.get( sym_code.raw(), "symbol does not exist" );
+   check( st.ring.has_value(), "checkpoints not enabled" );
+
+   const auto& ring = st.ring.value();
+   supply_checkpoints result {
+      .current = {
+         .block = current_block_time().slot,
+         .supply = st.supply.amount,
+         .minted = ring.minted,
+         .burned = ring.burned
+      },
+      .checkpoints = {}
+   };
+
+   // Until the ring is full head is zero, so the
+   // rotation below returns the insertion order
+   auto length = ring.checkpoints.size();
+   result.checkpoints.reserve(length);
+   for (size_t i = 0; i < length; i++) {
+      result.checkpoints.push_back(ring.checkpoints[(ring.head + i) % length]);
+   }
+
+   return result;
+}
+
+xtoken::token_status xtoken::getstatus(const symbol_code& sym_code, const vector<name>& owners) {
+   stats statstable( get_self(), sym_code.raw() );
+   const auto& st = statstable.get( sym_code.raw(), "symbol does not exist" );
+
+   token_status status {
+      .supply = st.supply,
+      .max_supply = st.max_supply,
+      .frozen = {}
+   };
+
+   status.frozen.reserve(owners.size());
+   for (const auto& owner : owners) {
+      status.frozen.push_back(is_frozen(owner));
+   }
+
+   return status;
+}
+
+uint32_t xtoken::now() {
+   return current_block_time().to_time_point().sec_since_epoch();
+}
+
+int64_t xtoken::calculate_new_current_limit(int64_t limit, int64_t old_limit, int64_t current_limit) {
+   int64_t difference = 0;
+   int64_t new_current_limit = 0;
+   if (old_limit > limit) {
+      difference = old_limit - limit;
+      new_current_limit = current_limit > difference ? current_limit - difference : 0;
+   } else {
+      difference = limit - old_limit;
+      new_current_limit = current_limit + difference;
+   }
+
+   return new_current_limit;
+}
+
+int64_t xtoken::get_current_limit(const limit_model& limit, uint32_t now) {
+   if (limit.current == limit.max || limit.timestamp + DURATION <= now) {
+      return limit.max;
+   }
+
+   uint64_t time_passed = now - limit.timestamp;
+   uint128_t replenished = (static_cast<uint128_t>(time_passed) * limit.rate) >> RATE_PRECISION_BITS;
+   uint128_t calculated_limit = static_cast<uint128_t>(limit.current) + replenished;
+
+   return calculated_limit > static_cast<uint128_t>(limit.max)
+      ? limit.max
+      : static_cast<int64_t>(calculated_limit);
 }
 
-void xtoken::change_minter_limit(xtoken::bridge_model& bridge, const asset& limit) {
-   asset old_limit = bridge.minting_max_limit;
-   asset current_limit = minting_current_limit_of(bridge);
-   bridge.minting_max_limit = limit;
-   bridge.minting_current_limit = calculate_new_current_limit(limit, old_limit, current_limit);
-   bridge.minting_rate = float(limit.amount) / DURATION;
-   bridge.minting_timestamp = current_block_time().to_time_point().sec_since_epoch();
+void xtoken::change_limit(limit_model& limit, int64_t new_limit, uint32_t now) {
+   int64_t current_limit = get_current_limit(limit, now);
+   limit.current = calculate_new_current_limit(new_limit, limit.max, current_limit);
+   limit.max = new_limit;
+   limit.rate = static_cast<uint64_t>((static_cast<uint128_t>(new_limit) << RATE_PRECISION_BITS) / DURATION);
+   limit.timestamp = now;
 }
 
-void xtoken::change_burner_limit(xtoken::bridge_model& bridge, const asset& limit) {
-   asset old_limit = bridge.burning_max_limit;
-   asset current_limit = burning_current_limit_of(bridge);
-   bridge.burning_max_limit = limit;
-   bridge.burning_current_limit = calculate_new_current_limit(limit, old_limit, current_limit);
-   bridge.burning_rate = float(limit.amount) / DURATION;
-   bridge.burning_timestamp = current_block_time().to_time_point().sec_since_epoch();
+void xtoken::use_limit(limit_model& limit, int64_t change, uint32_t now) {
+   limit.current = get_current_limit(limit, now) - change;
+   limit.timestamp = now;
 }
 
-void xtoken::use_minter_limits(xtoken::bridge_model& bridge, const asset& change) {
-   asset current_limit = minting_current_limit_of(bridge);
-   bridge.minting_timestamp = current_block_time().to_time_point().sec_since_epoch();
-   bridge.minting_current_limit = current_limit - change;
+// Replays the legacy replenishment up to now, so the
+// migrated limit keeps the same current value
+xtoken::limit_model xtoken::from_legacy_limit(
+   const asset& current_limit,
+   const asset& max_limit,
+   uint64_t timestamp,
+   float rate,
+   uint32_t now
+) {
+   int64_t current = max_limit.amount;
+   if (current_limit != max_limit && timestamp + DURATION > now) {
+      uint64_t legacy_rate = rate; // legacy code truncated the rate to an integer
+      current = std::min(max_limit.amount, current_limit.amount + static_cast<int64_t>((now - timestamp) * legacy_rate));
+   }
+
+   limit_model limit = {
+      .timestamp = now,
+      .rate = 0,
+      .current = current,
+      .max = max_limit.amount
+   };
+   limit.rate = static_cast<uint64_t>((static_cast<uint128_t>(limit.max) << RATE_PRECISION_BITS) / DURATION);
+
+   return limit;
+}
+
+xtoken::bridge_limits xtoken::from_legacy_bridge(const bridge_model& legacy, uint32_t now) {
+   return bridge_limits {
+      .account = legacy.account,
+      .minting = from_legacy_limit(
+         legacy.minting_current_limit,
+         legacy.minting_max_limit,
+         legacy.minting_timestamp,
+         legacy.minting_rate,
+         now
+      ),
+      .burning = from_legacy_limit(
+         legacy.burning_current_limit,
+         legacy.burning_max_limit,
+         legacy.burning_timestamp,
+         legacy.burning_rate,
+         now
+      ),
+      .minted = 0,
+      .burned = 0
+   };
 }
 
-void xtoken::use_burner_limits(xtoken::bridge_model& bridge, const asset& change) {
-   asset current_limit = burning_current_limit_of(bridge);
-   bridge.burning_timestamp = current_block_time().to_time_point().sec_since_epoch();
-   bridge.burning_current_limit = current_limit - change;
+// Dual-read while the bridges are being migrated (see migrate),
+// a bridge still in the legacy table is moved on its first use
+xtoken::limits::const_iterator xtoken::find_limits(limits& limitstable, const name& account, const symbol& sym) {
+   auto itr = limitstable.find( account.value );
+   if (itr != limitstable.end()) return itr;
+   if (migration::is_completed(get_self(), MIGRATION_STEP_BRIDGES)) return itr;
+
+   bridges bridgestable( get_self(), get_self().value );
+   auto legacy = bridgestable.find( account.value );
+   if (legacy == bridgestable.end() || legacy->minting_max_limit.symbol != sym) return itr;
+
+   itr = limitstable.emplace(get_self(), [&](auto& row) {
+      row = from_legacy_bridge(*legacy, now());
+   });
+   bridgestable.erase(legacy);
+
+   return itr;
 }
 
 void xtoken::setfreezeacc(const name& freezing_account) {
@@ -379,6 +832,8 @@ void xtoken::freeze(const name& account) {
    _frozens.emplace(get_self(), [&](auto& r) {
       r.account = account;
    });
+
+   set_frozen_flag(account, true);
 }
 
 void xtoken::unfreeze(const name& account) {
@@ -391,6 +846,8 @@ void xtoken::unfreeze(const name& account) {
    check(itr != _frozens.end(), "account not frozen");
 
    _frozens.erase(itr);
+
+   set_frozen_flag(account, false);
 }
 
 void xtoken::pullfrozen(const name& frozen, const name& to, const asset& quantity) {
@@ -412,5 +869,24 @@ void xtoken::pullfrozen(const name& frozen, const name& to, const asset& quantit
    sub_balance(frozen, quantity);
    add_balance(to, quantity, to);
 }
+
+// Realigns the balance rows flags with the frozensacc table,
+// needed for the accounts frozen before the flag was introduced
+void xtoken::syncfrozen(const name& account) {
+   require_auth(get_self());
+   set_frozen_flag(account, is_frozen(account));
+}
+
+void xtoken::set_frozen_flag(const name& account, bool frozen) {
+   accounts acnts(get_self(), account.value);
+   for (auto itr = acnts.begin(); itr != acnts.end(); itr++) {
+      if (itr->is_frozen() == frozen) continue;
+
+      acnts.modify(itr, same_payer, [&](auto& a) {
+         if (frozen) a.frozen.emplace(true);
+         else a.frozen.reset();
+      });
+   }
+}
 } /// namespace eosio
 
@@ -4,28 +4,81 @@
 #include <eosio/eosio.hpp>
 #include <eosio/system.hpp>
 #include <eosio/singleton.hpp>
+#include <eosio/binary_extension.hpp>
 
 #include <string>
 
+#include "migration.hpp"
+#include "stages.hpp"
+
 namespace eosio {
    using std::string;
+   using std::vector;
 
    class [[eosio::contract("xerc20.token")]] xtoken : public contract {
       public:
          using contract::contract;
 
+         struct mint_entry {
+            name     to;
+            asset    quantity;
+            string   memo;
+         };
+
+         // Mint and burn amounts available to the
+         // bridge at the current block time
+         struct bridge_headroom {
+            name     account;
+            asset    minting;
+            asset    burning;
+            asset    minting_max;
+            asset    burning_max;
+         };
+
+         struct supply_checkpoint {
+            uint32_t    block;   // block timestamp slot
+            int64_t     supply;
+            int64_t     minted;  // cumulative, since the ring was enabled
+            int64_t     burned;  // cumulative, since the ring was enabled
+         };
+
+         struct supply_checkpoints {
+            supply_checkpoint          current;
+            vector<supply_checkpoint>  checkpoints; // oldest first
+         };
+
+         struct token_status {
+            asset          supply;
+            asset          max_supply;
+            vector<bool>   frozen;
+         };
+
          ACTION create(const name& issuer, const asset& maximum_supply);
 
          ACTION mint(const name& caller, const name& to, const asset& quantity, const string& memo);
 
+         ACTION mintbatch(const name& caller, const vector<mint_entry>& entries);
+
          ACTION burn(const name& caller, const asset& quantity, const string& memo);
 
+         ACTION burnfee(const name& caller, const asset& quantity, const name& fee_recipient, const asset& fee);
+
          ACTION transfer(const name& from, const name& to, const asset& quantity, const string& memo);
 
          ACTION setlimits(const name& bridge, const asset& minting_limit, const asset& burning_limit);
 
+         [[eosio::action]]
+         migration::cursor migrate(uint32_t max_rows);
+
          ACTION setlockbox(const name& account);
 
+         ACTION setwrap(const name& token, const symbol& token_symbol, const symbol& symbol);
+
+         ACTION unwrap(const name& owner, const asset& quantity);
+
+         [[eosio::on_notify("*::transfer")]]
+         void ontransfer(const name& from, const name& to, const asset& quantity, const string& memo);
+
          ACTION open(const name& owner, const symbol& symbol, const name& ram_payer);
 
          ACTION close(const name& owner, const symbol& symbol);
@@ -38,6 +91,22 @@ namespace eosio {
 
          ACTION pullfrozen(const name& account, const name& to, const asset& quantity);
 
+         ACTION syncfrozen(const name& account);
+
+         [[eosio::action, eosio::read_only]]
+         vector<asset> getbalances(const symbol_code& sym_code, const vector<name>& owners);
+
+         [[eosio::action, eosio::read_only]]
+         vector<bridge_headroom> getheadroom(const symbol_code& sym_code);
+
+         ACTION setcheckpts(const symbol_code& sym_code, uint16_t size, uint32_t interval);
+
+         [[eosio::action, eosio::read_only]]
+         supply_checkpoints getcheckpts(const symbol_code& sym_code);
+
+         [[eosio::action, eosio::read_only]]
+         token_status getstatus(const symbol_code& sym_code, const vector<name>& owners);
+
          static asset get_supply(const name& token_contract_account, const symbol_code& sym_code) {
             stats statstable(token_contract_account, sym_code.raw());
             const auto& st = statstable.get(sym_code.raw(), "invalid supply symbol code");
@@ -50,30 +119,37 @@ namespace eosio {
             return ac.balance;
          }
 
-         static asset minting_max_limit_of(const name& token_contract_account, const name& bridge, const symbol& sym) {
-            bridges bridgestable(token_contract_account, token_contract_account.value);
-            auto idx = bridgestable.get_index<name("bysymbol")>();
-            auto itr = idx.lower_bound(sym.code().raw());
-            while (itr != idx.end() && itr->account != bridge) { itr++; }
+         // Indexes of the steps of migrate
+         static constexpr uint8_t MIGRATION_STEP_BRIDGES = 0;
+         static constexpr uint8_t MIGRATION_STEP_FROZEN = 1;
 
-            check(itr != idx.end(), "entry not found");
+         // NOTE: bridges not migrated yet are read from the legacy table
+         static asset minting_max_limit_of(const name& token_contract_account, const name& bridge, const symbol& sym) {
+            limits limitstable(token_contract_account, sym.code().raw());
+            auto itr = limitstable.find(bridge.value);
+            if (itr != limitstable.end()) return asset(itr->minting.max, sym);
+            check(!migration::is_completed(token_contract_account, MIGRATION_STEP_BRIDGES), "entry not found");
 
-            return itr->minting_max_limit;
+            bridges bridgestable(token_contract_account, token_contract_account.value);
+            return bridgestable.get(bridge.value, "entry not found").minting_max_limit;
          }
 
          static asset burning_max_limit_of(const name& token_contract_account, const name& bridge, const symbol& sym) {
-            bridges bridgestable(token_contract_account, token_contract_account.value);
-            auto idx = bridgestable.get_index<name("bysymbol")>();
-            auto itr = idx.lower_bound(sym.code().raw());
-            while (itr != idx.end() && itr->account != bridge) { itr++; }
+            limits limitstable(token_contract_account, sym.code().raw());
+            auto itr = limitstable.find(bridge.value);
+            if (itr != limitstable.end()) return asset(itr->burning.max, sym);
+            check(!migration::is_completed(token_contract_account, MIGRATION_STEP_BRIDGES), "entry not found");
 
-            check(itr != idx.end(), "entry not found");
-
-            return itr->burning_max_limit;
+            bridges bridgestable(token_contract_account, token_contract_account.value);
+            return bridgestable.get(bridge.value, "entry not found").burning_max_limit;
          }
 
+         using action_transfer = action_wrapper<"transfer"_n, &xtoken::transfer>;
+
       private:
-         uint64_t const DURATION = 86400; // 1 days in seconds
+         static constexpr uint64_t DURATION = 86400; // 1 days in seconds
+         static constexpr uint16_t MAX_CHECKPOINTS = 256;
+         static constexpr uint8_t RATE_PRECISION_BITS = 16; // fractional bits of limit_model::rate
 
          TABLE frozen_accounts {
             name     account;
@@ -84,23 +160,66 @@ namespace eosio {
          };
 
          TABLE account {
-            asset    balance;
+            asset                   balance;
+            binary_extension<bool>  frozen; // mirrors frozensacc, set only when frozen
 
             uint64_t primary_key() const {
                return balance.symbol.code().raw();
             }
+
+            bool is_frozen() const {
+               return frozen.value_or(false);
+            }
+         };
+
+         // Fixed size ring of supply checkpoints, a checkpoint is taken
+         // every `interval` operations or once per block when zero
+         struct supply_ring {
+            uint16_t                   size;
+            uint32_t                   interval;
+            uint32_t                   ops;
+            uint16_t                   head;
+            int64_t                    minted;
+            int64_t                    burned;
+            vector<supply_checkpoint>  checkpoints;
          };
 
          TABLE currency_stats {
-            asset    supply;
-            asset    max_supply;
-            name     issuer;
+            asset                         supply;
+            asset                         max_supply;
+            name                          issuer;
+            binary_extension<bool>        frozen_flags; // balance rows flags are authoritative, see is_frozen
+            binary_extension<supply_ring> ring; // set by setcheckpts
 
             uint64_t primary_key() const {
                return supply.symbol.code().raw();
             }
          };
 
+         // Minting or burning limit, amounts are expressed in
+         // the token smallest unit (symbol is the table scope)
+         struct limit_model {
+            uint32_t    timestamp;
+            uint64_t    rate; // per second, fixed-point (RATE_PRECISION_BITS)
+            int64_t     current;
+            int64_t     max;
+         };
+
+         // Scoped by symbol code
+         TABLE bridge_limits {
+            name           account;
+            limit_model    minting;
+            limit_model    burning;
+            int64_t        minted; // cumulative, checkpoints enabled or not
+            int64_t        burned; // cumulative, checkpoints enabled or not
+
+            uint64_t primary_key() const {
+               return account.value;
+            }
+         };
+
+         // NOTE: legacy layout, kept in order to migrate the
+         // existing rows to the limits table (see migrate)
          TABLE bridge_model {
             name        account;
             uint64_t    minting_timestamp;
@@ -128,21 +247,40 @@ namespace eosio {
          typedef eosio::multi_index< "bridges"_n, bridge_model,
             indexed_by< "bysymbol"_n, const_mem_fun<bridge_model, uint64_t, &bridge_model::secondary_key>
          > > bridges;
+         typedef eosio::multi_index< "limits"_n, bridge_limits > limits;
+
+         // Integrated lockbox: the underlying token is locked by
+         // this contract which mints/burns the wrapped symbol itself
+         struct wrap_config {
+            name     token;
+            symbol   token_symbol;
+            symbol   sym;
+         };
 
          using lockbox_singleton = singleton<"lockbox"_n, name>;
+         using wrap_singleton = singleton<"wrap"_n, wrap_config>;
          using freezing_account_singleton = singleton<"freezeacc"_n, name>;
 
+         // Define alias for ABI inclusion
+         using migration_cursor = migration::cursor_singleton;
+         using migration_position = migration::position_singleton;
+
          bool is_frozen(const name& account);
-         asset minting_current_limit_of(bridge_model& bridge);
-         asset burning_current_limit_of(bridge_model& bridge);
-         void use_minter_limits(bridge_model& bridge, const asset& change);
-         void use_burner_limits(bridge_model& bridge, const asset& change);
-         void change_minter_limit(bridge_model& bridge, const asset& limit);
-         void change_burner_limit(bridge_model& bridge, const asset& limit);
+         bool is_frozen(const currency_stats& stats, const account& row, const name& owner);
+         void sync_frozen_flags(currency_stats& stats);
+         void set_frozen_flag(const name& account, bool frozen);
          name check_freezing_requirements(const name& self);
-         bridge_model get_empty_bridge_model(const name& account, const symbol& symbol);
-         asset calculate_new_current_limit(const asset& limit, const asset& old_limit, const asset& current_limit);
-         asset get_current_limit(const asset& current_limit, const asset& max_limit, const uint64_t timestamp, const uint64_t rate_per_second);
+         uint32_t now();
+         int64_t calculate_new_current_limit(int64_t limit, int64_t old_limit, int64_t current_limit);
+         int64_t get_current_limit(const limit_model& limit, uint32_t now);
+         void record_checkpoint(currency_stats& stats, int64_t minted, int64_t burned);
+         void use_minting_limit(const name& caller, const symbol& sym, int64_t amount);
+         void use_burning_limit(const name& caller, const symbol& sym, int64_t amount);
+         void change_limit(limit_model& limit, int64_t new_limit, uint32_t now);
+         void use_limit(limit_model& limit, int64_t change, uint32_t now);
+         limit_model from_legacy_limit(const asset& current_limit, const asset& max_limit, uint64_t timestamp, float rate, uint32_t now);
+         bridge_limits from_legacy_bridge(const bridge_model& legacy, uint32_t now);
+         limits::const_iterator find_limits(limits& limitstable, const name& account, const symbol& sym);
          void sub_balance(const name& owner, const asset& value);
          void add_balance(const name& owner, const asset& value, const name& ram_payer);
    };
@@ -0,0 +1,61 @@
+// Built WITHOUT coverage instrumentation, it provides the
+// callback inserted by the compiler in each basic block.
+#include <cstring>
+
+#include "coverage.hpp"
+
+namespace {
+   constexpr size_t MAP_SIZE = 1 << 16;
+
+   uint8_t run_map[MAP_SIZE];
+   uint8_t global_map[MAP_SIZE];
+   uintptr_t prev = 0;
+   uint64_t blocks = 0;
+   bool enabled = false;
+}
+
+extern "C" void __sanitizer_cov_trace_pc() {
+   if (!enabled) return;
+
+   // AFL style edge hashing
+   uintptr_t cur = reinterpret_cast<uintptr_t>(__builtin_return_address(0));
+   cur = (cur >> 4) ^ (cur << 8);
+   run_map[(cur ^ prev) & (MAP_SIZE - 1)] = 1;
+   prev = cur >> 1;
+   blocks++;
+}
+
+namespace fuzz {
+   void begin() {
+      std::memset(run_map, 0, sizeof(run_map));
+      prev = 0;
+      blocks = 0;
+      enabled = true;
+   }
+
+   uint64_t end() {
+      enabled = false;
+      return blocks;
+   }
+
+   size_t merge() {
+      size_t fresh = 0;
+      for (size_t i = 0; i < MAP_SIZE; i++) {
+         if (run_map[i] && !global_map[i]) {
+            global_map[i] = 1;
+            fresh++;
+         }
+      }
+      return fresh;
+   }
+
+   size_t edges() {
+      size_t count = 0;
+      for (size_t i = 0; i < MAP_SIZE; i++) count += global_map[i];
+      return count;
+   }
+
+   void reset() {
+      std::memset(global_map, 0, sizeof(global_map));
+   }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Executed blocks and edges of the code built with
+// -fsanitize-coverage=trace-pc, counted between begin()
+// and end() only (see coverage.cpp)
+namespace fuzz {
+   void begin();
+
+   // Returns the number of executed blocks
+   uint64_t end();
+
+   // Merges the edges of the last run in the global map,
+   // returns how many of them were never seen before
+   size_t merge();
+
+   size_t edges();
+
+   // Forgets the edges seen so far
+   void reset();
+}
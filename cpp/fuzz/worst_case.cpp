@@ -0,0 +1,331 @@
+// Coverage guided search of the costliest inputs of the settle and
+// swap decoding (codec/, shared with the contracts). Instead of
+// crashes it maximizes the number of executed blocks, a deterministic
+// proxy of the instructions billed on chain: mutants reaching new
+// edges are kept in the corpus, the costliest ones are reported.
+//
+// Usage: worst-case [-runs N] [-max_len N] [-seed N] [-top N] [-o dir] [target...]
+//
+//    settle   preimage => swap event (pam::authorize and settle2 decoding)
+//    event    swap event bytes => swap event
+//    memo     transfer memo => swap memo fields
+//
+// NOTE: the TEE signature recovery and the table lookups are not
+// covered, their cost doesn't depend on the input. Neither is the
+// sha256 of the preimage (event id), a host function on chain whose
+// cost is linear in the size: here it would outweigh the decoding.
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <functional>
+
+#include "../codec/codec.hpp"
+#include "coverage.hpp"
+
+using namespace pnetwork::codec;
+
+namespace {
+   struct target {
+      const char* name;
+      size_t max_len;
+      size_t align; // offset of the 32 bytes words
+      bool text; // report the inputs as strings
+      std::vector<bytes> seeds;
+      std::function<error(const bytes&)> run;
+   };
+
+   struct finding {
+      bytes input;
+      uint64_t cost;
+      error result;
+   };
+
+   struct options {
+      uint64_t runs = 100000;
+      size_t max_len = 0; // per target default
+      uint64_t seed = 1;
+      size_t top = 5;
+      std::string out_dir;
+      std::vector<std::string> targets;
+   };
+
+   const bytes32 ORIGIN_CHAIN_ID = to_bytes32(static_cast<uint128>(1));
+   const char* DEST_CHAIN_ID = "aca376f206b8fc25a6ed44dbdc66547c36c6c33e3a119ffbeaef943642f0e906";
+
+   bytes to_bytes(const std::string& str) {
+      return bytes(str.begin(), str.end());
+   }
+
+   bytes sample_event(size_t data_size) {
+      swap_event event;
+      event.nonce = 1;
+      event.token = to_bytes32(std::string("xtkn.token"));
+      bytes chain_id;
+      from_hex(DEST_CHAIN_ID, chain_id);
+      std::copy(chain_id.begin(), chain_id.end(), event.destination_chain_id.begin());
+      event.amount = static_cast<uint128>(1000000000000000000ULL);
+      event.sender = to_bytes32(std::string("user"));
+      event.recipient = "recipient";
+      event.data = bytes(data_size, 0xab);
+      return encode_swap_event(event);
+   }
+
+   bytes sample_preimage(uint8_t protocol, const bytes& event_bytes) {
+      bytes preimage = { 0x01, protocol };
+      auto append = [&](const bytes32& field) { preimage.insert(preimage.end(), field.begin(), field.end()); };
+      append(ORIGIN_CHAIN_ID);
+      append(to_bytes32(static_cast<uint128>(0xb10c)));
+      append(to_bytes32(static_cast<uint128>(0x7a)));
+      append(to_bytes32(std::string("adapter")));
+      append(to_bytes32(std::string("swap")));
+      for (size_t i = 0; i < 3; i++) append(bytes32{});
+
+      bytes payload = protocol == PROTOCOL_EOS
+         ? to_bytes("{\"event_bytes\":\"" + to_hex(event_bytes) + "\"}")
+         : event_bytes;
+      preimage.insert(preimage.end(), payload.begin(), payload.end());
+      return preimage;
+   }
+
+   std::vector<target> get_targets() {
+      // Same steps of pam::verify_event_data and pam::authorize, the
+      // context and the topics are compared at fixed offsets
+      target settle = { "settle", 2048, EVENT_DATA_OFFSET % 32, false, {}, [](const bytes& input) {
+         if (input.size() < EVENT_DATA_OFFSET) return error::truncated;
+
+         bytes event_data;
+         const uint8_t* data = input.data() + EVENT_DATA_OFFSET;
+         error e = decode_event_data(input[PROTOCOL_OFFSET], data, input.size() - EVENT_DATA_OFFSET, event_data);
+         if (e != error::ok) return e;
+
+         swap_event event;
+         e = decode_swap_event(event_data, event);
+         if (e != error::ok) return e;
+
+         // Rules of the eosio::name constructor
+         return is_valid_name(event.recipient) ? error::ok : error::invalid_recipient;
+      }};
+      for (uint8_t protocol : { PROTOCOL_EVM, PROTOCOL_EOS, PROTOCOL_EOS_BINARY }) {
+         settle.seeds.push_back(sample_preimage(protocol, sample_event(0)));
+         settle.seeds.push_back(sample_preimage(protocol, sample_event(64)));
+      }
+
+      target event = { "event", 2048, 0, false, { sample_event(0), sample_event(256) }, [](const bytes& input) {
+         swap_event decoded;
+         return decode_swap_event(input, decoded);
+      }};
+
+      // Transfer memos are capped at 256 bytes by the tokens
+      target memo = { "memo", 256, 0, true, {
+         to_bytes("user,0x" + std::string(DEST_CHAIN_ID) + ",0xe396757ec7e6ac7c8e5abe7285dde47b98f22db8,0"),
+         to_bytes("user,0x" + std::string(DEST_CHAIN_ID) + ",recipient,1"),
+      }, [](const bytes& input) {
+         swap_memo parsed;
+         return parse_swap_memo(std::string(input.begin(), input.end()), parsed);
+      }};
+
+      return { settle, event, memo };
+   }
+
+   class mutator {
+   public:
+      mutator(uint64_t seed, size_t max_len, size_t align) : rng(seed), max_len(max_len), align(align) {}
+
+      bytes mutate(bytes input) {
+         size_t n = 1 + below(4);
+         for (size_t i = 0; i < n; i++) mutate_once(input);
+         if (input.size() > max_len) input.resize(max_len);
+         return input;
+      }
+
+      size_t below(size_t n) {
+         return n == 0 ? 0 : std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+      }
+
+   private:
+      void mutate_once(bytes& input) {
+         static const std::vector<std::string> tokens = {
+            ",", ",,", "0x", "0", "1", "ff", "zz", "{\"event_bytes\":\"", "\"}",
+         };
+
+         size_t pos = below(input.size() + 1);
+         switch (below(8)) {
+            case 0: // flip a bit
+               if (!input.empty()) input[below(input.size())] ^= 1 << below(8);
+               break;
+            case 1: // random byte
+               if (!input.empty()) input[below(input.size())] = below(256);
+               break;
+            case 2: { // insert random bytes
+               bytes chunk(1 + below(32));
+               for (auto& b : chunk) b = below(256);
+               input.insert(input.begin() + pos, chunk.begin(), chunk.end());
+               break;
+            }
+            case 3: { // insert a token
+               const std::string& token = tokens[below(tokens.size())];
+               input.insert(input.begin() + pos, token.begin(), token.end());
+               break;
+            }
+            case 4: // erase a range
+               if (pos < input.size()) input.erase(input.begin() + pos, input.begin() + pos + below(input.size() - pos + 1));
+               break;
+            case 5: { // repeat a range
+               if (pos >= input.size()) break;
+               bytes chunk(input.begin() + pos, input.begin() + pos + 1 + below(std::min<size_t>(16, input.size() - pos)));
+               for (size_t i = below(16); i > 0 && input.size() < max_len; i--) {
+                  input.insert(input.begin() + pos, chunk.begin(), chunk.end());
+               }
+               break;
+            }
+            case 6: { // big number in a 32 bytes word (i.e. the lengths)
+               if (pos < align) break;
+               size_t word = pos - (pos - align) % 32;
+               if (word + 32 > input.size()) break;
+               std::fill(input.begin() + word, input.begin() + word + 32, 0);
+               for (size_t i = 32 - 1 - below(16); i < 32; i++) input[word + i] = below(256);
+               break;
+            }
+            case 7: // grow up to the size limit
+               while (input.size() < max_len) input.push_back(input.empty() ? 0 : input[below(input.size())]);
+               break;
+         }
+      }
+
+      std::mt19937_64 rng;
+      size_t max_len;
+      size_t align;
+   };
+
+   // Keeps the costliest findings, one per cost and size
+   void record(std::vector<finding>& top, size_t limit, const finding& f) {
+      for (const auto& other : top) {
+         if (other.cost == f.cost && other.input.size() == f.input.size()) return;
+      }
+      top.push_back(f);
+      std::sort(top.begin(), top.end(), [](const finding& a, const finding& b) { return a.cost > b.cost; });
+      if (top.size() > limit) top.pop_back();
+   }
+
+   std::string printable(const target& t, const bytes& input, size_t limit) {
+      if (!t.text) {
+         std::string hex = to_hex(input.data(), std::min(input.size(), limit / 2));
+         return input.size() * 2 > limit ? hex + "..." : hex;
+      }
+
+      std::string str;
+      for (size_t i = 0; i < input.size() && str.size() < limit; i++) {
+         char c = input[i];
+         str += (c >= 0x20 && c < 0x7f) ? std::string(1, c) : "\\x" + to_hex(&input[i], 1);
+      }
+      return input.size() > limit ? str + "..." : str;
+   }
+
+   void report(const target& t, const char* kind, const std::vector<finding>& top, const options& opts) {
+      for (size_t i = 0; i < top.size(); i++) {
+         const auto& f = top[i];
+         std::printf("%-8s %-9s %10llu %6zu %9.1f  %-22s %s\n",
+            t.name,
+            kind,
+            static_cast<unsigned long long>(f.cost),
+            f.input.size(),
+            f.input.empty() ? 0.0 : double(f.cost) / f.input.size(),
+            get_error_message(f.result),
+            printable(t, f.input, 48).c_str());
+
+         if (!opts.out_dir.empty()) {
+            std::ofstream file(opts.out_dir + "/" + t.name + "-" + kind + "-" + std::to_string(i) + ".hex");
+            file << to_hex(f.input) << "\n";
+         }
+      }
+   }
+
+   uint64_t execute(const target& t, const bytes& input, error& result) {
+      fuzz::begin();
+      result = t.run(input);
+      return fuzz::end();
+   }
+
+   void search(const target& t, const options& opts) {
+      size_t max_len = opts.max_len > 0 ? opts.max_len : t.max_len;
+      mutator m(opts.seed, max_len, t.align);
+
+      std::vector<bytes> corpus;
+      std::vector<finding> accepted, rejected;
+      uint64_t baseline = UINT64_MAX;
+
+      // Returns whether the input reached new edges
+      auto run = [&](const bytes& input, uint64_t& cost) {
+         finding f = { input, 0, error::ok };
+         cost = f.cost = execute(t, input, f.result);
+         record(f.result == error::ok ? accepted : rejected, opts.top, f);
+         return fuzz::merge() > 0;
+      };
+
+      fuzz::reset();
+      uint64_t cost = 0;
+      for (const auto& seed : t.seeds) {
+         run(seed, cost);
+         baseline = std::min(baseline, cost);
+         corpus.push_back(seed);
+      }
+
+      for (uint64_t i = 0; i < opts.runs; i++) {
+         // Half of the time from the costliest findings
+         const auto& pool = m.below(2) == 0 && !accepted.empty() ? accepted : rejected;
+         const bytes& parent = m.below(2) == 0 && !pool.empty()
+            ? pool[m.below(pool.size())].input
+            : corpus[m.below(corpus.size())];
+
+         bytes child = m.mutate(parent);
+         if (run(child, cost)) corpus.push_back(child);
+      }
+
+      std::printf("# %s: %llu runs, max_len %zu, corpus %zu, edges %zu, cheapest seed %llu blocks\n",
+         t.name,
+         static_cast<unsigned long long>(opts.runs),
+         max_len,
+         corpus.size(),
+         fuzz::edges(),
+         static_cast<unsigned long long>(baseline));
+      std::printf("%-8s %-9s %10s %6s %9s  %-22s %s\n", "target", "outcome", "blocks", "size", "blocks/B", "result", "input");
+      report(t, "accepted", accepted, opts);
+      report(t, "rejected", rejected, opts);
+      std::printf("\n");
+   }
+
+   int usage() {
+      std::fprintf(stderr, "Usage: worst-case [-runs N] [-max_len N] [-seed N] [-top N] [-o dir] [settle|event|memo...]\n");
+      return 2;
+   }
+}
+
+int main(int argc, char** argv) {
+   options opts;
+   for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      bool has_value = i + 1 < argc;
+      if (arg == "-runs" && has_value) opts.runs = std::stoull(argv[++i]);
+      else if (arg == "-max_len" && has_value) opts.max_len = std::stoull(argv[++i]);
+      else if (arg == "-seed" && has_value) opts.seed = std::stoull(argv[++i]);
+      else if (arg == "-top" && has_value) opts.top = std::stoull(argv[++i]);
+      else if (arg == "-o" && has_value) opts.out_dir = argv[++i];
+      else if (arg[0] == '-') return usage();
+      else opts.targets.push_back(arg);
+   }
+
+   bool found = opts.targets.empty();
+   for (const auto& t : get_targets()) {
+      if (!opts.targets.empty() && std::find(opts.targets.begin(), opts.targets.end(), t.name) == opts.targets.end())
+         continue;
+
+      found = true;
+      search(t, opts);
+   }
+
+   return found ? 0 : usage();
+}
@@ -66,6 +66,26 @@ function adapter.get_settle_params {
     add_key_value_string _output "$_output" "metadata" "$metadata"   # FIXME: custom parsing?
 }
 
+function adapter.get_settle2_params {
+    local __output
+    local _output
+    local caller
+    local metadata
+
+    __output="$1"
+    shift 1
+    caller="$1"
+    metadata="$2"
+
+    exit_if_empty "$caller" "caller param is missing"
+    exit_if_empty "$metadata" "metadata param is missing"
+
+    add_key_value_string _output "$_output" "caller" "$caller"
+    add_key_value_string _output "$_output" "metadata" "$metadata"   # FIXME: custom parsing?
+
+    eval "$__output"="'$_output'"
+}
+
 function adapter.get_setfeemanagr_params {
     local __output
     local _output
@@ -135,6 +155,8 @@ function adapter.get_json_params {
 
     settle) adapter.get_settle_params "$__params" "$@" ;;
 
+    settle2) adapter.get_settle2_params "$__params" "$@" ;;
+
     setfeemanagr) adapter.get_setfeemanagr_params "$__params" "$@" ;;
 
     adduserdata) adapter.get_adduserdata_params "$__params" "$@" ;;
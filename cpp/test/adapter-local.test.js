@@ -9,6 +9,7 @@ const {
 } = require('@eosnetwork/vert')
 const { deploy } = require('./utils/deploy')
 const {
+  _0x,
   no0x,
   active,
   errors,
@@ -20,13 +21,14 @@ const {
   getSymbolCodeRaw,
   getAccountsBalances,
   getSingletonInstance,
+  getActionReturnValue,
   fromEthersPublicKey,
   deserializeEventBytes,
   getOperation,
   serializeOperation,
 } = require('./utils')
 
-const { toBeHex } = require('ethers')
+const { toBeHex, sha256 } = require('ethers')
 const {
   Protocols,
   Chains,
@@ -222,6 +224,12 @@ describe('Adapter Testing - Local deployment', () => {
         .send(active(adapter.account))
     })
 
+    it('Should enable the metrics successfully', async () => {
+      await adapter.contract.actions
+        .setmetrics([true])
+        .send(active(adapter.account))
+    })
+
     it('Should set the local chain id successfully', async () => {
       await adapter.contract.actions
         .setchainid([EOSChainId])
@@ -315,6 +323,10 @@ describe('Adapter Testing - Local deployment', () => {
       expect(deserialized.sender).to.be.equal(user)
       expect(deserialized.recipient).to.be.equal(recipient)
       expect(deserialized.data).to.be.equal(data)
+
+      const result = getActionReturnValue(adapter.contract, 'swap')
+      expect(result.nonce).to.be.equal(before.storage.nonce)
+      expect(result.event_hash).to.be.equal(no0x(sha256(`0x${eventBytes}`)))
     })
 
     describe('adapter::adduserdata', () => {
@@ -521,14 +533,459 @@ describe('Adapter Testing - Local deployment', () => {
         .getTableRow(BigInt(storage.nonce))
 
       expect(pastEvent.event_id).to.be.equal(no0x(expectedEventId))
+
+      const result = getActionReturnValue(adapter.contract, 'settle')
+      expect(result.event_id).to.be.equal(no0x(expectedEventId))
+      expect(result.quantity).to.be.equal(
+        Asset.from(evmSwapAmount, xsymbolPrecision).toString(),
+      )
+    })
+
+    it('Should reject upon replay attacks', async () => {
+      const action = adapter.contract.actions
+        .settle([user, no0x(operation), no0x(metadata)])
+        .send(active(user))
+
+      await expectToThrow(action, errors.EVENT_ALREADY_PROCESSED)
+    })
+  })
+
+  describe('adapter::settle2', () => {
+    const evmSwapAmount = 3
+    const evmSender = '0xf39fd6e51aad88f6f4ce6ab8827279cfffb92266'
+
+    const operation = getOperation({
+      local: true,
+      nonce: 22,
+      token: symbolPrecision,
+      originChainId: evmOriginChainId,
+      destinationChainId: Chains(Protocols.Eos).Mainnet,
+      amount: evmSwapAmount,
+      sender: evmSender,
+      recipient,
+    })
+
+    const event = {
+      blockHash: operation.blockId,
+      transactionHash: operation.txId,
+      address: evmAdapter,
+      topics: [evmTopicZero],
+      data: serializeOperation(operation),
+    }
+
+    const metadata = {
+      preimage: evmEA.getEventPreImage(event),
+      signature: evmEA.formatEosSignature(evmEA.sign(event)),
+    }
+
+    it('Should settle the amount derived from the preimage', async () => {
+      const before = getAccountsBalances(
+        [recipient, adapter.account, lockbox.account],
+        [token, xerc20],
+      )
+
+      const storage = getSingletonInstance(adapter.contract, TABLE_STORAGE)
+
+      await adapter.contract.actions
+        .settle2([user, no0x(metadata)])
+        .send(active(user))
+
+      const after = getAccountsBalances(
+        [recipient, adapter.account, lockbox.account],
+        [token, xerc20],
+      )
+
+      const swapAmount = Asset.from(evmSwapAmount, symbolPrecision)
+      expect(
+        substract(
+          before[lockbox.account][token.symbol],
+          after[lockbox.account][token.symbol],
+        ),
+      ).to.be.deep.equal(swapAmount)
+      expect(
+        substract(
+          after[recipient][token.symbol],
+          before[recipient][token.symbol],
+        ),
+      ).to.be.deep.equal(swapAmount)
+
+      const expectedEventId = evmEA.getEventId(event)
+
+      const pastEvent = adapter.contract.tables
+        .pastevents(nameToBigInt(adapter.account))
+        .getTableRow(BigInt(storage.nonce))
+
+      expect(pastEvent.event_id).to.be.equal(no0x(expectedEventId))
+
+      const result = getActionReturnValue(adapter.contract, 'settle2')
+      expect(result.event_id).to.be.equal(no0x(expectedEventId))
+      expect(result.quantity).to.be.equal(
+        Asset.from(evmSwapAmount, xsymbolPrecision).toString(),
+      )
     })
 
     it('Should reject upon replay attacks', async () => {
+      const action = adapter.contract.actions
+        .settle2([user, no0x(metadata)])
+        .send(active(user))
+
+      await expectToThrow(action, errors.EVENT_ALREADY_PROCESSED)
+    })
+
+    it('Should reject the same event already settled through settle', async () => {
       const action = adapter.contract.actions
         .settle([user, no0x(operation), no0x(metadata)])
         .send(active(user))
 
       await expectToThrow(action, errors.EVENT_ALREADY_PROCESSED)
     })
+
+    it('Should notify the receivers through their settle2 handler', async () => {
+      const userdata = '0xc0ffee'
+      const withUserdata = getOperation({
+        local: true,
+        nonce: 30,
+        token: symbolPrecision,
+        originChainId: evmOriginChainId,
+        destinationChainId: Chains(Protocols.Eos).Mainnet,
+        amount: 1,
+        sender: evmSender,
+        recipient: receiver.account,
+        data: userdata,
+      })
+
+      const userdataEvent = {
+        blockHash: withUserdata.blockId,
+        transactionHash: withUserdata.txId,
+        address: evmAdapter,
+        topics: [evmTopicZero],
+        data: serializeOperation(withUserdata),
+      }
+
+      const userdataMetadata = {
+        preimage: evmEA.getEventPreImage(userdataEvent),
+        signature: evmEA.formatEosSignature(evmEA.sign(userdataEvent)),
+      }
+
+      await adapter.contract.actions
+        .settle2([user, no0x(userdataMetadata)])
+        .send(active(user))
+
+      // The recipient is notified with the settle2 action, a receiver
+      // handling "*::settle" only would not be called, see test.receiver
+      const results = receiver.contract.tables
+        .results(nameToBigInt(receiver.account))
+        .getTableRows()
+
+      expect(results).to.be.deep.equal([{ id: 0, data: no0x(userdata) }])
+    })
+  })
+
+  describe('adapter read-only actions', () => {
+    it('Should return the whole configuration', async () => {
+      await adapter.contract.actions.getconfig([]).send(active(user))
+
+      const config = getActionReturnValue(adapter.contract, 'getconfig')
+      const storage = getSingletonInstance(adapter.contract, TABLE_STORAGE)
+
+      expect(config.registry).to.be.deep.equal(
+        getSingletonInstance(adapter.contract, 'regadapter'),
+      )
+      expect(config.nonce).to.be.equal(storage.nonce)
+      expect(config.feesmanager).to.be.equal(feemanager)
+      expect(config.local_chain_id).to.be.equal(EOSChainId)
+      expect(config.mappings).to.have.length(1)
+      expect(config.mappings[0].emitter).to.be.equal(evmAdapter)
+      expect(config.mappings[0].topic_zero).to.be.equal(evmTopicZero)
+      expect(config.pam_registry).to.be.equal('')
+    })
+
+    it('Should quote the fees for the given quantity', async () => {
+      const amount = 10
+      const quantity = Asset.from(amount, xsymbolPrecision)
+
+      await adapter.contract.actions.quotefees([quantity]).send(active(user))
+
+      const intFees = (amount * FEE_BASIS_POINTS) / FEE_BASIS_POINTS_DIVISOR
+      expect(getActionReturnValue(adapter.contract, 'quotefees')).to.be.equal(
+        Asset.from(intFees, xsymbolPrecision).toString(),
+      )
+    })
+
+    it('Should return the minimum fee for small quantities', async () => {
+      const quantity = Asset.from(0.0001, xsymbolPrecision)
+
+      await adapter.contract.actions.quotefees([quantity]).send(active(user))
+
+      expect(getActionReturnValue(adapter.contract, 'quotefees')).to.be.equal(
+        minFee.toString(),
+      )
+    })
+
+    it('Should tell which events have been processed', async () => {
+      const processed = adapter.contract.tables
+        .pastevents(nameToBigInt(adapter.account))
+        .getTableRows()
+        .map(R.prop('event_id'))
+      const unknown = no0x(bytes32('0x01'))
+
+      await adapter.contract.actions
+        .isprocessed([[...processed, unknown]])
+        .send(active(user))
+
+      const result = getActionReturnValue(adapter.contract, 'isprocessed')
+      expect(result).to.be.deep.equal([...processed.map(R.T), false])
+    })
+
+    describe('adapter::checksettle', () => {
+      const STATUS_OK = 0
+      const STATUS_INVALID_NONCE = 8
+      const STATUS_INVALID_TOKEN = 18
+      const STATUS_ALREADY_PROCESSED = 19
+      const STATUS_INVALID_PREIMAGE = 22
+      const STATUS_MALFORMED_SIGNATURE = 23
+      const STATUS_INVALID_EVENT_DATA = 24
+      const STATUS_MALFORMED_EVENT = 25
+      const STATUS_INVALID_NUMBER = 26
+      const STATUS_INVALID_RECIPIENT_LEN = 27
+      const EVENT_DATA_OFFSET = 258
+      const SWAP_EVENT_HEADER_SIZE = 192
+
+      const getSettleSample = _nonce => {
+        const operation = getOperation({
+          local: true,
+          nonce: _nonce,
+          token: symbolPrecision,
+          originChainId: evmOriginChainId,
+          destinationChainId: Chains(Protocols.Eos).Mainnet,
+          amount: 1,
+          sender: '0xf39fd6e51aad88f6f4ce6ab8827279cfffb92266',
+          recipient,
+        })
+
+        const event = {
+          blockHash: operation.blockId,
+          transactionHash: operation.txId,
+          address: evmAdapter,
+          topics: [evmTopicZero],
+          data: serializeOperation(operation),
+        }
+
+        const metadata = {
+          preimage: evmEA.getEventPreImage(event),
+          signature: evmEA.formatEosSignature(evmEA.sign(event)),
+        }
+
+        return { operation, event, metadata }
+      }
+
+      // Signs the preimage as it is, so that the malformed
+      // ones get past the signature check
+      const getSignedMetadata = _preimage => ({
+        preimage: no0x(_preimage),
+        signature: no0x(
+          evmEA.formatEosSignature(evmEA.signBytes(_0x(_preimage))),
+        ),
+      })
+
+      const checkSettle = async (_operation, _metadata) => {
+        await adapter.contract.actions
+          .checksettle([no0x(_operation), _metadata])
+          .send(active(user))
+
+        return getActionReturnValue(adapter.contract, 'checksettle').code
+      }
+
+      it('Should return ok for a valid operation', async () => {
+        const { operation, event, metadata } = getSettleSample(23)
+
+        await adapter.contract.actions
+          .checksettle([no0x(operation), no0x(metadata)])
+          .send(active(user))
+
+        const result = getActionReturnValue(adapter.contract, 'checksettle')
+
+        expect(result.code).to.be.equal(STATUS_OK)
+        expect(result.event_id).to.be.equal(no0x(evmEA.getEventId(event)))
+      })
+
+      it('Should return the relative code instead of asserting', async () => {
+        const { operation, metadata } = getSettleSample(24)
+        const wrongNonce = { ...operation, nonce: 25 }
+        const wrongToken = { ...operation, token: bytes32('0x01') }
+
+        await adapter.contract.actions
+          .checksettle([no0x(wrongNonce), no0x(metadata)])
+          .send(active(user))
+
+        expect(
+          getActionReturnValue(adapter.contract, 'checksettle').code,
+        ).to.be.equal(STATUS_INVALID_NONCE)
+
+        await adapter.contract.actions
+          .checksettle([no0x(wrongToken), no0x(metadata)])
+          .send(active(user))
+
+        expect(
+          getActionReturnValue(adapter.contract, 'checksettle').code,
+        ).to.be.equal(STATUS_INVALID_TOKEN)
+      })
+
+      it('Should detect an already processed operation', async () => {
+        const { operation, metadata } = getSettleSample(26)
+
+        await adapter.contract.actions
+          .settle([user, no0x(operation), no0x(metadata)])
+          .send(active(user))
+
+        await adapter.contract.actions
+          .checksettle([no0x(operation), no0x(metadata)])
+          .send(active(user))
+
+        expect(
+          getActionReturnValue(adapter.contract, 'checksettle').code,
+        ).to.be.equal(STATUS_ALREADY_PROCESSED)
+      })
+
+      it('Should reject a nonce wider than 64 bits', async () => {
+        const { operation } = getSettleSample(28)
+
+        // Same low 64 bits of the operation nonce
+        const event = {
+          blockHash: operation.blockId,
+          transactionHash: operation.txId,
+          address: evmAdapter,
+          topics: [evmTopicZero],
+          data: serializeOperation({
+            ...operation,
+            nonce: (1n << 64n) + BigInt(operation.nonce),
+          }),
+        }
+
+        const metadata = {
+          preimage: evmEA.getEventPreImage(event),
+          signature: evmEA.formatEosSignature(evmEA.sign(event)),
+        }
+
+        expect(await checkSettle(operation, no0x(metadata))).to.be.equal(
+          STATUS_INVALID_NUMBER,
+        )
+      })
+
+      it('Should reject a signature shorter than 65 bytes', async () => {
+        const { operation, metadata } = getSettleSample(29)
+        const truncated = {
+          ...no0x(metadata),
+          signature: no0x(metadata.signature).slice(0, 64 * 2),
+        }
+
+        expect(await checkSettle(operation, truncated)).to.be.equal(
+          STATUS_MALFORMED_SIGNATURE,
+        )
+      })
+
+      it('Should reject the event bytes not hex encoded (protocol 0x02)', async () => {
+        const { operation, metadata } = getSettleSample(31)
+        const preimage = no0x(metadata.preimage)
+
+        // Odd number of hex chars in the JSON string
+        const json = Buffer.from('{"event_bytes":"0"}').toString('hex')
+        const eos =
+          preimage.slice(0, 2) +
+          '02' +
+          preimage.slice(4, EVENT_DATA_OFFSET * 2) +
+          json
+
+        expect(
+          await checkSettle(operation, getSignedMetadata(eos)),
+        ).to.be.equal(STATUS_INVALID_EVENT_DATA)
+      })
+
+      it('Should reject the event data not longer than the header', async () => {
+        const { operation, metadata } = getSettleSample(32)
+        const size = EVENT_DATA_OFFSET + SWAP_EVENT_HEADER_SIZE
+        const preimage = no0x(metadata.preimage).slice(0, size * 2)
+
+        expect(
+          await checkSettle(operation, getSignedMetadata(preimage)),
+        ).to.be.equal(STATUS_MALFORMED_EVENT)
+      })
+
+      it('Should reject a recipient length exceeding the event data', async () => {
+        const { operation, metadata } = getSettleSample(33)
+        const preimage = no0x(metadata.preimage)
+        const offset = (EVENT_DATA_OFFSET + 32 * 5) * 2
+
+        for (const length of ['ff'.repeat(32), bytes32('0x1000')]) {
+          const exceeding =
+            preimage.slice(0, offset) +
+            no0x(length) +
+            preimage.slice(offset + 64)
+
+          expect(
+            await checkSettle(operation, getSignedMetadata(exceeding)),
+          ).to.be.equal(STATUS_INVALID_RECIPIENT_LEN)
+        }
+      })
+
+      it('Should reject a preimage shorter than the event payload', async () => {
+        const { operation, metadata } = getSettleSample(27)
+
+        // Context and event payload up to the topics, less one byte
+        for (const size of [163, EVENT_DATA_OFFSET - 1]) {
+          const truncated = {
+            ...no0x(metadata),
+            preimage: no0x(metadata.preimage).slice(0, size * 2),
+          }
+
+          await adapter.contract.actions
+            .checksettle([no0x(operation), truncated])
+            .send(active(user))
+
+          expect(
+            getActionReturnValue(adapter.contract, 'checksettle').code,
+          ).to.be.equal(STATUS_INVALID_PREIMAGE)
+        }
+      })
+    })
+
+    it('Should return the throughput metrics', async () => {
+      const METRICS_DIRECTION_SWAP = 0
+      const METRICS_DIRECTION_SETTLE = 1
+      const chainId = no0x(bytes32(evmOriginChainId))
+      const swapFees = Asset.from(
+        (10 * FEE_BASIS_POINTS) / FEE_BASIS_POINTS_DIVISOR,
+        xsymbolPrecision,
+      )
+      const swapVolume = substract(
+        Asset.from(10, xsymbolPrecision),
+        swapFees,
+      )
+      // See the settle, settle2 and checksettle tests above
+      const settleVolume = Asset.from(5 + 3 + 1, xsymbolPrecision)
+
+      await adapter.contract.actions.getmetrics([]).send(active(user))
+
+      const metrics = getActionReturnValue(adapter.contract, 'getmetrics')
+
+      expect(metrics).to.be.deep.equal([
+        {
+          direction: METRICS_DIRECTION_SWAP,
+          chain_id: chainId,
+          count: 2,
+          volume: String(swapVolume.units.toNumber() * 2),
+          fees: String(swapFees.units.toNumber() * 2),
+          last_nonce: 1,
+        },
+        {
+          direction: METRICS_DIRECTION_SETTLE,
+          chain_id: chainId,
+          count: 3,
+          volume: String(settleVolume.units.toNumber()),
+          fees: '0',
+          last_nonce: 26,
+        },
+      ])
+    })
   })
 })
@@ -12,6 +12,7 @@ const {
   getAccountCodeRaw,
   fromEthersPublicKey,
   getSingletonInstance,
+  getActionReturnValue,
 } = require('./utils')
 const { toBeHex, stripZerosLeft } = require('ethers')
 const {
@@ -25,7 +26,7 @@ const { TimePointSec } = require('@wharfkit/antelope')
 const TEE_ADDRESS_CHANGE_GRACE_PERIOD_MS = 172800 * 1000
 const TABLE_STORAGE = 'storage'
 const TABLE_TEE = 'tee'
-const TABLE_LOCAL_CHAIN_ID = 'chainid'
+const TABLE_LOCAL_CHAIN_ID = 'chainid2'
 
 describe('Adapter tests', () => {
   const symbol = 'TST'
@@ -291,7 +292,7 @@ describe('Adapter tests', () => {
       const storage = getSingletonInstance(adapter.contract, TABLE_STORAGE)
       const tee = getSingletonInstance(adapter.contract, TABLE_TEE)
       const mappingsRow = adapter.contract.tables
-        .mappings(getAccountCodeRaw(adapter.account))
+        .mappings2(getAccountCodeRaw(adapter.account))
         .getTableRows()
 
       expect(row).to.be.deep.equal({
@@ -379,26 +380,39 @@ describe('Adapter tests', () => {
       await expectToThrow(action, errors.AUTH_MISSING(adapter.account))
     })
 
+    it('Should throw if the chain id is not 32 bytes', async () => {
+      const action = adapter.contract.actions
+        .setchainid(['ababba'])
+        .send(active(adapter.account))
+
+      await expectToThrow(action, errors.EXPECTED_32_BYTES('chain_id'))
+    })
+
     it('Should set the local chain id correctly', async () => {
-      const chain_id = 'ababba'
       await adapter.contract.actions
-        .setchainid([chain_id])
+        .setchainid([EOSChainId])
         .send(active(adapter.account))
 
       const local_chain_id = getSingletonInstance(
         adapter.contract,
         TABLE_LOCAL_CHAIN_ID,
       )
-      expect(local_chain_id.chain_id).to.be.equal(chain_id)
+      expect(local_chain_id.chain_id).to.be.equal(EOSChainId)
     })
 
-    it('Should update the local chain id correctly', async () => {
+    it('Should only let the adapter migrate the PAM settings', async () => {
+      const action = adapter.contract.actions.migrate([10]).send(active(evil))
+
+      await expectToThrow(action, errors.AUTH_MISSING(adapter.account))
+
+      // Settings already stored with the fixed width layout
       await adapter.contract.actions
-        .setchainid([EOSChainId])
+        .migrate([10])
         .send(active(adapter.account))
 
-      const local_chain_id = getSingletonInstance(adapter.contract, 'chainid')
-      expect(local_chain_id.chain_id).to.be.equal(EOSChainId)
+      expect(
+        getActionReturnValue(adapter.contract, 'migrate'),
+      ).to.be.deep.equal({ step: 2, migrated: 0, done: true })
     })
   })
 
@@ -517,7 +531,7 @@ describe('Adapter tests', () => {
         .send(active(adapter.account))
 
       const row = adapter.contract.tables
-        .mappings(getAccountCodeRaw(adapter.account))
+        .mappings2(getAccountCodeRaw(adapter.account))
         .getTableRow(stripZerosLeft(`0x${originChainId}`))
 
       expect(row.chain_id).to.be.equal(originChainId)
@@ -531,7 +545,7 @@ describe('Adapter tests', () => {
         .send(active(adapter.account))
 
       const emitterRow = adapter.contract.tables
-        .mappings(getAccountCodeRaw(adapter.account))
+        .mappings2(getAccountCodeRaw(adapter.account))
         .getTableRow(stripZerosLeft(`0x${originChainId}`))
 
       expect(emitterRow.chain_id).to.be.equal(originChainId)
@@ -539,4 +553,49 @@ describe('Adapter tests', () => {
       expect(emitterRow.topic_zero).to.be.equal(evmTopicZero)
     })
   })
+
+  describe('adapter::setmetrics', () => {
+    it('Should throw if called by not authorized account', async () => {
+      const action = adapter.contract.actions
+        .setmetrics([true])
+        .send(active(evil))
+
+      await expectToThrow(action, errors.AUTH_MISSING(adapter.account))
+    })
+
+    it('Should throw if adapter is not initialized', async () => {
+      const action = notInitAdapter.contract.actions
+        .setmetrics([true])
+        .send(active(notInitAdapter.account))
+
+      await expectToThrow(action, errors.NOT_INITIALIZED)
+    })
+
+    it('Should enable the metrics correctly', async () => {
+      await adapter.contract.actions
+        .setmetrics([true])
+        .send(active(adapter.account))
+
+      const storage = getSingletonInstance(adapter.contract, TABLE_STORAGE)
+
+      expect(storage).be.deep.equal({
+        nonce: 0,
+        feesmanager: feemanager,
+        metrics: [],
+      })
+    })
+
+    it('Should disable the metrics correctly', async () => {
+      await adapter.contract.actions
+        .setmetrics([false])
+        .send(active(adapter.account))
+
+      const storage = getSingletonInstance(adapter.contract, TABLE_STORAGE)
+
+      expect(storage).be.deep.equal({
+        nonce: 0,
+        feesmanager: feemanager,
+      })
+    })
+  })
 })
@@ -0,0 +1,171 @@
+const { expect } = require('chai')
+const { sha256 } = require('ethers')
+const { execFileSync } = require('child_process')
+const {
+  Chains,
+  Versions,
+  Protocols,
+  ProofcastEventAttestator,
+} = require('@pnetwork/event-attestator')
+const { no0x, getOperation, serializeOperation } = require('./utils')
+
+const CODEC = 'codec/build/pnetwork-codec'
+
+const codec = (_command, _lines) =>
+  execFileSync(CODEC, [_command], { input: _lines.join('\n') })
+    .toString()
+    .trim()
+    .split('\n')
+
+describe('Codec testing', () => {
+  const recipient = 'recipient'
+  const operations = [0, 1, 2].map(_nonce =>
+    getOperation({
+      nonce: _nonce,
+      token:
+        '0x000000000000000000000000810090f35dfa6b18b5eb59d298e2a2443a2811e2',
+      originChainId: Chains(Protocols.Evm).Mainnet,
+      destinationChainId: Chains(Protocols.Eos).Mainnet,
+      amount: 1.5 * (_nonce + 1),
+      sender:
+        '0x000000000000000000000000f39fd6e51aad88f6f4ce6ab8827279cfffb92266',
+      recipient,
+      data: _nonce % 2 === 0 ? '' : '0xc0ffee',
+    }),
+  )
+
+  const getEvent = _operation => ({
+    blockHash: _operation.blockId,
+    transactionHash: _operation.txId,
+    account: 'adapter',
+    action: 'swap',
+    data: { event_bytes: no0x(serializeOperation(_operation)) },
+  })
+
+  it('Should encode the swap events as the JS utils', () => {
+    const lines = operations.map(_op =>
+      [
+        _op.nonce,
+        no0x(_op.token),
+        no0x(_op.destinationChainId),
+        _op.amount,
+        no0x(_op.sender),
+        _op.recipient,
+        no0x(_op.data),
+      ].join(' '),
+    )
+
+    expect(codec('encode-event', lines)).to.be.deep.equal(
+      operations.map(_op => no0x(serializeOperation(_op))),
+    )
+  })
+
+  it('Should decode the swap events', () => {
+    const decoded = codec(
+      'decode-event',
+      operations.map(_op => serializeOperation(_op)),
+    ).map(JSON.parse)
+
+    decoded.forEach((_event, _i) => {
+      expect(_event.nonce).to.be.equal(operations[_i].nonce)
+      expect(_event.amount).to.be.equal(operations[_i].amount)
+      expect(_event.recipient).to.be.equal(recipient)
+      expect(_event.data).to.be.equal(no0x(operations[_i].data))
+    })
+  })
+
+  for (const protocol of ['Eos', 'EosBinary']) {
+    const ea = new ProofcastEventAttestator({
+      version: Versions.V1,
+      protocolId: Protocols[protocol],
+      chainId: Chains(Protocols.Eos).Jungle,
+    })
+
+    const preimages = operations.map(_op => ea.getEventPreImage(getEvent(_op)))
+
+    it(`Should hash the event id (protocol ${protocol})`, () => {
+      expect(codec('event-id', preimages)).to.be.deep.equal(
+        preimages.map(_preimage => no0x(sha256(_preimage))),
+      )
+    })
+
+    it(`Should reject the empty recipient (protocol ${protocol})`, () => {
+      // Still longer than the header, thanks to the user data
+      const operation = { ...operations[1], recipient: '' }
+      const preimage = ea.getEventPreImage(getEvent(operation))
+
+      expect(() => codec('operation', [preimage])).to.throw(
+        /stdin:1: invalid recipient/,
+      )
+    })
+
+    it(`Should derive the settle operation (protocol ${protocol})`, () => {
+      const derived = codec('operation', preimages).map(JSON.parse)
+
+      derived.forEach((_op, _i) => {
+        const expected = no0x(operations[_i])
+        expect(_op).to.be.deep.equal({
+          ...expected,
+          originChainId: no0x(ea.chainId),
+        })
+      })
+    })
+  }
+
+  it('Should parse the userdata flag of the memos as std::stoi to uint8_t', () => {
+    const memo = _flag => `user,0x01,0xabc,${_flag}`
+    const flags = ['0', '1', '255', '256', '257', '-1', '+2', ' 1', '1abc']
+
+    const decoded = codec('decode-memo', flags.map(memo)).map(JSON.parse)
+
+    expect(decoded.map(_memo => _memo.hasUserdata)).to.be.deep.equal([
+      false,
+      true,
+      true,
+      false,
+      true,
+      true,
+      true,
+      true,
+      true,
+    ])
+
+    for (const flag of ['abc', '-', '2147483648']) {
+      expect(() => codec('decode-memo', [memo(flag)])).to.throw(
+        /invalid memo format/,
+      )
+    }
+  })
+
+  it('Should require the swap events to be longer than the header', () => {
+    const HEADER_SIZE = 192
+    const header = '00'.repeat(HEADER_SIZE)
+
+    expect(() => codec('decode-event', [header])).to.throw(
+      /stdin:1: truncated data/,
+    )
+
+    // Recipient length of 1, recipient 'a'
+    const [decoded] = codec('decode-event', [
+      `${header.slice(0, -2)}0161`,
+    ]).map(JSON.parse)
+
+    expect(decoded.recipient).to.be.equal('a')
+  })
+
+  it('Should reject the nonces wider than 64 bits', () => {
+    // Low 64 bits as the valid event, a byte set past them
+    const event = no0x(serializeOperation(operations[1]))
+    const nonce = event.slice(0, 32) + '01' + event.slice(34, 64)
+
+    expect(() =>
+      codec('decode-event', [nonce + event.slice(64)]),
+    ).to.throw(/stdin:1: number overflow/)
+  })
+
+  it('Should report the malformed lines', () => {
+    expect(() => codec('preimage', ['0102', 'zz'])).to.throw(
+      /stdin:1: truncated data/,
+    )
+  })
+})
@@ -8,6 +8,7 @@ const {
   getAccountCodeRaw,
   getSymbolCodeRaw,
   getSingletonInstance,
+  getActionReturnValue,
 } = require('./utils/eos-ext')
 const errors = require('./utils/errors')
 const { substract } = require('./utils/wharfkit-ext')
@@ -326,6 +327,55 @@ describe('Feesmanager testing', () => {
   })
 
   describe('feesmanager::withdrawto', () => {
+    const fund = async _balance => {
+      await token.contract.actions.create([issuer, token.maxSupply]).send()
+      await token.contract.actions
+        .issue([issuer, _balance, ''])
+        .send(active(issuer))
+      await token.contract.actions
+        .transfer([issuer, feesmanager.account, _balance, ''])
+        .send(active(issuer))
+    }
+
+    it('Should reject if not authorized', async () => {
+      const allowanceValue = '50.0000 TKN'
+      const tokenSymbol = Asset.from(allowanceValue).symbol
+      await fund(allowanceValue)
+      await feesmanager.contract.actions
+        .setallowance([node1, token.account, allowanceValue])
+        .send(active(feesmanager.account))
+
+      let action = feesmanager.contract.actions
+        .withdrawto([node1, token.account, tokenSymbol])
+        .send(active(evil))
+
+      await expectToThrow(action, errors.AUTH_MISSING(node1))
+
+      action = feesmanager.contract.actions
+        .withdrawmtto([node1, [token.account], [tokenSymbol]])
+        .send(active(evil))
+
+      await expectToThrow(action, errors.AUTH_MISSING(node1))
+
+      await feesmanager.contract.actions
+        .withdrawto([node1, token.account, tokenSymbol])
+        .send(active(node1))
+    })
+
+    it('Should reject when the token does not match the symbol', async () => {
+      const allowanceValue = '50.0000 TKN'
+      await fund(allowanceValue)
+      await feesmanager.contract.actions
+        .setallowance([node1, token.account, allowanceValue])
+        .send(active(feesmanager.account))
+
+      const action = feesmanager.contract.actions
+        .withdrawto([node1, token2.account, Asset.from(allowanceValue).symbol])
+        .send(active(feesmanager.account))
+
+      await expectToThrow(action, errors.TOKEN_SYMBOL_MISMATCH)
+    })
+
     it('Should reject if no allowance found', async () => {
       const tokenSymbol = Asset.from(`0.000 ${token.symbol}`).symbol
       const action = feesmanager.contract.actions
@@ -540,4 +590,174 @@ describe('Feesmanager testing', () => {
       })
     })
   })
+  describe('feesmanager::distribute', () => {
+    it('Should reject if not authorized', async () => {
+      const tokenSymbol = Asset.from(`0.0000 ${symbol}`).symbol
+      const action = feesmanager.contract.actions
+        .distribute([token.account, tokenSymbol, [node1]])
+        .send(active(evil))
+
+      await expectToThrow(action, errors.AUTH_MISSING(feesmanager.account))
+    })
+
+    it('Should withdraw to many nodes at once', async () => {
+      const feesmanagerBalance = '100.0000 TKN'
+      const allowanceValue = '50.0000 TKN'
+      const tokenSymbol = Asset.from(allowanceValue).symbol
+      await token.contract.actions.create([issuer, token.maxSupply]).send()
+      await token.contract.actions
+        .issue([issuer, feesmanagerBalance, ''])
+        .send(active(issuer))
+      await token.contract.actions
+        .transfer([issuer, feesmanager.account, feesmanagerBalance, ''])
+        .send(active(issuer))
+
+      for (const node of [node1, recipient]) {
+        await feesmanager.contract.actions
+          .setallowance([node, token.account, allowanceValue])
+          .send(active(feesmanager.account))
+      }
+
+      await feesmanager.contract.actions
+        .distribute([token.account, tokenSymbol, [node1, recipient]])
+        .send(active(feesmanager.account))
+
+      const balanceOf = _account =>
+        token.contract.tables
+          .accounts(getAccountCodeRaw(_account))
+          .getTableRows()[0]
+      const totalAllowance = feesmanager.contract.tables
+        .totallowance(getAccountCodeRaw(token.account))
+        .getTableRows()
+
+      expect(balanceOf(node1)).to.be.deep.equal({ balance: allowanceValue })
+      expect(balanceOf(recipient)).to.be.deep.equal({
+        balance: allowanceValue,
+      })
+      expect(balanceOf(feesmanager.account)).to.be.deep.equal({
+        balance: '0.0000 TKN',
+      })
+      expect(totalAllowance).to.be.deep.equal([{ allowance: '0.0000 TKN' }])
+    })
+  })
+
+  describe('feesmanager accumulator mode', () => {
+    const tokenSymbol = Asset.from(`0.0000 ${symbol}`).symbol
+    const fees = '100.0000 TKN'
+
+    const setup = async () => {
+      await token.contract.actions.create([issuer, token.maxSupply]).send()
+      await token.contract.actions
+        .issue([issuer, fees, ''])
+        .send(active(issuer))
+
+      await feesmanager.contract.actions
+        .addpool([token.account, tokenSymbol])
+        .send(active(feesmanager.account))
+      await feesmanager.contract.actions
+        .setweight([node1, 1])
+        .send(active(feesmanager.account))
+      await feesmanager.contract.actions
+        .setweight([recipient, 3])
+        .send(active(feesmanager.account))
+
+      // Fees received after the nodes registration
+      await token.contract.actions
+        .transfer([issuer, feesmanager.account, fees, ''])
+        .send(active(issuer))
+    }
+
+    it('Should reject if not authorized', async () => {
+      let action = feesmanager.contract.actions
+        .addpool([token.account, tokenSymbol])
+        .send(active(evil))
+
+      await expectToThrow(action, errors.AUTH_MISSING(feesmanager.account))
+
+      action = feesmanager.contract.actions
+        .setweight([node1, 1])
+        .send(active(evil))
+
+      await expectToThrow(action, errors.AUTH_MISSING(feesmanager.account))
+    })
+
+    it('Should share the received fees by weight', async () => {
+      await setup()
+
+      await feesmanager.contract.actions
+        .getclaimable([node1, token.account, tokenSymbol])
+        .send(active(evil))
+
+      expect(
+        getActionReturnValue(feesmanager.contract, 'getclaimable'),
+      ).to.be.equal('25.0000 TKN')
+
+      await feesmanager.contract.actions
+        .claim([node1, token.account, tokenSymbol])
+        .send(active(node1))
+      await feesmanager.contract.actions
+        .claim([recipient, token.account, tokenSymbol])
+        .send(active(feesmanager.account))
+
+      const balanceOf = _account =>
+        token.contract.tables
+          .accounts(getAccountCodeRaw(_account))
+          .getTableRows()[0]
+
+      expect(balanceOf(node1)).to.be.deep.equal({ balance: '25.0000 TKN' })
+      expect(balanceOf(recipient)).to.be.deep.equal({
+        balance: '75.0000 TKN',
+      })
+      expect(balanceOf(feesmanager.account)).to.be.deep.equal({
+        balance: '0.0000 TKN',
+      })
+
+      const pool = feesmanager.contract.tables
+        .pools(getAccountCodeRaw(feesmanager.account))
+        .getTableRows()[0]
+
+      expect(pool.tracked).to.be.equal(0)
+    })
+
+    it('Should not allow the fees owed to the weighted nodes', async () => {
+      await setup()
+
+      // Syncs the pool, 75 TKN are still owed to the recipient
+      await feesmanager.contract.actions
+        .claim([node1, token.account, tokenSymbol])
+        .send(active(node1))
+
+      const action = feesmanager.contract.actions
+        .setallowance([node1, token.account, '1.0000 TKN'])
+        .send(active(feesmanager.account))
+
+      await expectToThrow(action, errors.INSUFFICIENT_BALANCE_SET)
+    })
+
+    it('Should reject a claim not authorized by the node', async () => {
+      await setup()
+
+      const action = feesmanager.contract.actions
+        .claim([node1, token.account, tokenSymbol])
+        .send(active(evil))
+
+      await expectToThrow(action, errors.AUTH_MISSING(node1))
+    })
+
+    it('Should not reward the nodes registered after the fees', async () => {
+      await setup()
+
+      await feesmanager.contract.actions
+        .setweight([issuer, 4])
+        .send(active(feesmanager.account))
+
+      await feesmanager.contract.actions
+        .getclaimable([issuer, token.account, tokenSymbol])
+        .send(active(evil))
+
+      expect(
+        getActionReturnValue(feesmanager.contract, 'getclaimable'),
+      ).to.be.equal('0.0000 TKN')
+    })
+  })
 })
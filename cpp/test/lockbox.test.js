@@ -7,6 +7,7 @@ const {
   precision,
   getAccountCodeRaw,
   getSymbolCodeRaw,
+  getActionReturnValue,
 } = require('./utils/eos-ext')
 const errors = require('./utils/errors')
 const { substract } = require('./utils/wharfkit-ext')
@@ -130,6 +131,41 @@ describe('Lockbox testing', () => {
         xerc20: xerc20.account,
         xerc20_symbol: xsymbolPrecision,
       })
+    
+      const wrapRoute = lockbox.contract.tables
+        .routes(getAccountCodeRaw(token.account))
+        .getTableRow(getSymbolCodeRaw(token.maxSupply))
+      const unwrapRoute = lockbox.contract.tables
+        .routes(getAccountCodeRaw(xerc20.account))
+        .getTableRow(getSymbolCodeRaw(xerc20.maxSupply))
+
+      expect(wrapRoute).to.be.deep.equal({
+        sym: symbolPrecision,
+        direction: 0,
+        counterpart: xerc20.account,
+        counterpart_symbol: xsymbolPrecision,
+        total: 0,
+      })
+      expect(unwrapRoute).to.be.deep.equal({
+        sym: xsymbolPrecision,
+        direction: 1,
+        counterpart: token.account,
+        counterpart_symbol: symbolPrecision,
+        total: 0,
+      })
+    })
+
+    it('Should only let the lockbox migrate the routes', async () => {
+      const action = lockbox.contract.actions.migrate([10]).send(active(evil))
+
+      await expectToThrow(action, errors.AUTH_MISSING(lockbox.account))
+
+      // Routes already in place, nothing to add
+      await lockbox.contract.actions.migrate([10]).send()
+
+      expect(
+        getActionReturnValue(lockbox.contract, 'migrate'),
+      ).to.be.deep.equal({ step: 1, migrated: 1, done: true })
     })
   })
 
@@ -213,5 +249,80 @@ describe('Lockbox testing', () => {
         ),
       ).to.be.equal(quantity)
     })
+
+    it('Should account the collateral against the supply', async () => {
+      await lockbox.contract.actions.getcollat([]).send(active(user))
+
+      expect(
+        getActionReturnValue(lockbox.contract, 'getcollat'),
+      ).to.be.deep.equal([
+        {
+          token: token.account,
+          deposited: `10.0000 ${token.symbol}`,
+          released: `5.0000 ${token.symbol}`,
+          outstanding: `5.0000 ${token.symbol}`,
+          locked: `5.0000 ${token.symbol}`,
+          xerc20: xerc20.account,
+          supply: `5.0000 ${xerc20.symbol}`,
+        },
+      ])
+    })
+
+    it('Should release the collateral minted through mintbatch', async () => {
+      await xerc20.contract.actions
+        .setlimits([
+          bridge,
+          `100.0000 ${xerc20.symbol}`,
+          `100.0000 ${xerc20.symbol}`,
+        ])
+        .send(active(xerc20.account))
+
+      const before = getAccountsBalances(
+        [lockbox.account, bridge, recipient],
+        [token, xerc20],
+      )
+
+      await xerc20.contract.actions
+        .mintbatch([
+          bridge,
+          [
+            {
+              to: lockbox.account,
+              quantity: `2.0000 ${xerc20.symbol}`,
+              memo: '',
+            },
+            { to: recipient, quantity: `1.0000 ${xerc20.symbol}`, memo: '' },
+          ],
+        ])
+        .send(active(bridge))
+
+      const after = getAccountsBalances(
+        [lockbox.account, bridge, recipient],
+        [token, xerc20],
+      )
+
+      // Same as a mint to the lockbox, the collateral goes to the caller
+      expect(
+        String(
+          substract(before.lockbox[token.symbol], after.lockbox[token.symbol]),
+        ),
+      ).to.be.equal(`2.0000 ${token.symbol}`)
+      expect(
+        String(
+          substract(after.bridge[token.symbol], before.bridge[token.symbol]),
+        ),
+      ).to.be.equal(`2.0000 ${token.symbol}`)
+      expect(
+        String(
+          substract(
+            after.recipient[xerc20.symbol],
+            before.recipient[xerc20.symbol],
+          ),
+        ),
+      ).to.be.equal(`1.0000 ${xerc20.symbol}`)
+      expect(after.lockbox[xerc20.symbol]).to.be.deep.equal(
+        before.lockbox[xerc20.symbol],
+      )
+    })
   })
 })
@@ -0,0 +1,522 @@
+const { expect } = require('chai')
+const { Blockchain, expectToThrow } = require('@eosnetwork/vert')
+const { Asset, TimePointSec } = require('@wharfkit/antelope')
+const { deploy } = require('./utils/deploy')
+const {
+  active,
+  precision,
+  getSymbolCodeRaw,
+  getAccountCodeRaw,
+  getActionReturnValue,
+  getSingletonInstance,
+} = require('./utils/eos-ext')
+const errors = require('./utils/errors')
+
+// Legacy rows are written straight into the contract tables, as
+// the contracts deployed before the layout changes would have left
+// them, then moved by migrate or on their first use (dual-read).
+describe('Storage migrations', () => {
+  describe('xerc20.token bridges -> limits', () => {
+    const symbol = 'TKN'
+    const symbolPrecision = precision(0, symbol)
+    const account = 'tkn.token'
+    const maxSupply = Asset.from(500000000, symbolPrecision)
+    const DURATION = 24 * 60 * 60 // 1 day
+
+    const issuer = 'issuer'
+    const recipient = 'recipient'
+    const bridges = ['bridge.a', 'bridge.b', 'bridge.c']
+    const unknown = 'unknown'
+
+    const blockchain = new Blockchain()
+    const timestamp = 1726133966
+    let xerc20
+
+    const getLimits = _bridge =>
+      xerc20.tables
+        .limits(getSymbolCodeRaw(maxSupply))
+        .getTableRow(getAccountCodeRaw(_bridge))
+
+    const getLegacy = _bridge =>
+      xerc20.tables
+        .bridges(getAccountCodeRaw(account))
+        .getTableRow(getAccountCodeRaw(_bridge))
+
+    before(async () => {
+      blockchain.createAccounts(issuer, recipient, unknown, ...bridges)
+      xerc20 = deploy(blockchain, account, 'contracts/build/xerc20.token')
+      blockchain.setTime(TimePointSec.fromMilliseconds(timestamp * 1000))
+
+      await xerc20.actions.create([issuer, maxSupply]).send()
+
+      const max = Asset.from(1000, symbolPrecision).toString()
+      for (const bridge of bridges) {
+        xerc20.tables
+          .bridges(getAccountCodeRaw(account))
+          .set(getAccountCodeRaw(bridge), account, {
+            account: bridge,
+            minting_timestamp: timestamp,
+            minting_rate: 1000 / DURATION,
+            minting_current_limit: max,
+            minting_max_limit: max,
+            burning_timestamp: timestamp,
+            burning_rate: 1000 / DURATION,
+            burning_current_limit: max,
+            burning_max_limit: max,
+          })
+      }
+    })
+
+    it('Should move a legacy bridge on its first use', async () => {
+      const [bridge] = bridges
+      expect(getLimits(bridge)).to.be.undefined
+
+      await xerc20.actions
+        .mint([bridge, recipient, `10 ${symbol}`, ''])
+        .send(active(bridge))
+
+      const limits = getLimits(bridge)
+      expect(limits.account).to.be.equal(bridge)
+      expect(limits.minting.max).to.be.equal(1000)
+      expect(getLegacy(bridge)).to.be.undefined
+    })
+
+    it('Should migrate the remaining bridges in chunks', async () => {
+      await xerc20.actions.migrate([1]).send()
+
+      expect(getActionReturnValue(xerc20, 'migrate')).to.be.deep.equal({
+        step: 0,
+        migrated: 1,
+        done: false,
+      })
+      expect(getLimits(bridges[1]).account).to.be.equal(bridges[1])
+      expect(getLegacy(bridges[1])).to.be.undefined
+      expect(getLegacy(bridges[2])).to.not.be.undefined
+
+      // Resumes from the cursor
+      await xerc20.actions.migrate([10]).send()
+
+      expect(getActionReturnValue(xerc20, 'migrate')).to.be.deep.equal({
+        step: 2,
+        migrated: 2,
+        done: true,
+      })
+      expect(getLimits(bridges[2]).account).to.be.equal(bridges[2])
+      expect(getLegacy(bridges[2])).to.be.undefined
+    })
+
+    it('Should revert when the migration is already completed', async () => {
+      const action = xerc20.actions.migrate([10]).send()
+      await expectToThrow(action, errors.MIGRATION_COMPLETED)
+    })
+
+    it('Should keep using the migrated bridges', async () => {
+      for (const bridge of bridges) {
+        await xerc20.actions
+          .mint([bridge, recipient, `1 ${symbol}`, ''])
+          .send(active(bridge))
+      }
+
+      const action = xerc20.actions
+        .mint([unknown, recipient, `1 ${symbol}`, ''])
+        .send(active(unknown))
+
+      await expectToThrow(
+        action,
+        'eosio_assert: only lockbox or supported bridge can mint',
+      )
+    })
+  })
+
+  describe('xerc20.token frozensacc -> account flags', () => {
+    const symbol = 'TKN'
+    const account = 'tkn.token'
+    const maxSupply = Asset.from(500000000, precision(0, symbol))
+
+    const issuer = 'issuer'
+    const user = 'user'
+    const bridge = 'bridge'
+    const frozen = ['frozen.a', 'frozen.b']
+
+    const blockchain = new Blockchain()
+    let xerc20
+
+    const getBalanceRow = _account =>
+      xerc20.tables
+        .accounts(getAccountCodeRaw(_account))
+        .getTableRow(getSymbolCodeRaw(maxSupply))
+
+    const getStat = () =>
+      xerc20.tables
+        .stat(getSymbolCodeRaw(maxSupply))
+        .getTableRow(getSymbolCodeRaw(maxSupply))
+
+    // Accounts frozen before the flag was introduced have a
+    // balance row without it, as well as the stats row
+    before(async () => {
+      blockchain.createAccounts(issuer, user, bridge, ...frozen)
+      xerc20 = deploy(blockchain, account, 'contracts/build/xerc20.token')
+
+      xerc20.tables
+        .stat(getSymbolCodeRaw(maxSupply))
+        .set(getSymbolCodeRaw(maxSupply), account, {
+          supply: `300 ${symbol}`,
+          max_supply: maxSupply.toString(),
+          issuer,
+        })
+
+      for (const _account of [user, ...frozen]) {
+        xerc20.tables
+          .accounts(getAccountCodeRaw(_account))
+          .set(getSymbolCodeRaw(maxSupply), _account, {
+            balance: `100 ${symbol}`,
+          })
+      }
+
+      for (const _account of frozen) {
+        xerc20.tables
+          .frozensacc(getAccountCodeRaw(account))
+          .set(getAccountCodeRaw(_account), account, { account: _account })
+      }
+    })
+
+    const expectFrozen = async () => {
+      const from = xerc20.actions
+        .transfer([frozen[0], user, `1 ${symbol}`, ''])
+        .send(active(frozen[0]))
+
+      await expectToThrow(from, errors.FROM_ACCOUNT_IS_FROZEN)
+
+      const to = xerc20.actions
+        .transfer([user, frozen[1], `1 ${symbol}`, ''])
+        .send(active(user))
+
+      await expectToThrow(to, errors.TO_ACCOUNT_IS_FROZEN)
+    }
+
+    it('Should fallback on frozensacc until migrated', async () => {
+      expect(getBalanceRow(frozen[0])).to.be.deep.equal({
+        balance: `100 ${symbol}`,
+      })
+
+      await expectFrozen()
+    })
+
+    it('Should set the flags in chunks', async () => {
+      await xerc20.actions.migrate([1]).send()
+
+      expect(getActionReturnValue(xerc20, 'migrate')).to.be.deep.equal({
+        step: 1,
+        migrated: 1,
+        done: false,
+      })
+      expect(getBalanceRow(frozen[0]).frozen).to.be.true
+      expect(getBalanceRow(frozen[1])).to.not.have.property('frozen')
+
+      await expectFrozen()
+
+      // Resumes from the saved position
+      await xerc20.actions.migrate([10]).send()
+
+      expect(getActionReturnValue(xerc20, 'migrate')).to.be.deep.equal({
+        step: 2,
+        migrated: 2,
+        done: true,
+      })
+      expect(getBalanceRow(frozen[1]).frozen).to.be.true
+      expect(getBalanceRow(user)).to.not.have.property('frozen')
+      expect(getSingletonInstance(xerc20, 'migrationpos')).to.be.undefined
+
+      await expectFrozen()
+    })
+
+    it('Should mark the stats row on its next update', async () => {
+      expect(getStat()).to.not.have.property('frozen_flags')
+
+      await xerc20.actions
+        .setlimits([bridge, `100 ${symbol}`, `100 ${symbol}`])
+        .send()
+      await xerc20.actions
+        .mint([bridge, user, `1 ${symbol}`, ''])
+        .send(active(bridge))
+
+      expect(getStat().frozen_flags).to.be.true
+
+      await expectFrozen()
+    })
+  })
+
+  describe('xerc20.token frozen flags without legacy accounts', () => {
+    const symbol = 'TKN'
+    const account = 'tkn.token'
+    const maxSupply = Asset.from(500000000, precision(0, symbol))
+
+    const issuer = 'issuer'
+    const user = 'user'
+    const unflagged = 'unflagged'
+
+    const blockchain = new Blockchain()
+    let xerc20
+
+    // A frozensacc row without the balance flag and a pending
+    // migration cursor: transfer would reject the account if it
+    // read any of them
+    before(async () => {
+      blockchain.createAccounts(issuer, user, unflagged)
+      xerc20 = deploy(blockchain, account, 'contracts/build/xerc20.token')
+
+      await xerc20.actions.create([issuer, maxSupply]).send()
+
+      xerc20.tables
+        .accounts(getAccountCodeRaw(unflagged))
+        .set(getSymbolCodeRaw(maxSupply), unflagged, {
+          balance: `100 ${symbol}`,
+        })
+      xerc20.tables
+        .frozensacc(getAccountCodeRaw(account))
+        .set(getAccountCodeRaw(unflagged), account, { account: unflagged })
+      xerc20.tables
+        .migration(getAccountCodeRaw(account))
+        .set(getAccountCodeRaw('migration'), account, {
+          step: 0,
+          migrated: 0,
+          done: false,
+        })
+    })
+
+    it('Should check the balance flags only', async () => {
+      const stat = xerc20.tables
+        .stat(getSymbolCodeRaw(maxSupply))
+        .getTableRow(getSymbolCodeRaw(maxSupply))
+
+      expect(stat.frozen_flags).to.be.true
+
+      await xerc20.actions
+        .transfer([unflagged, user, `1 ${symbol}`, ''])
+        .send(active(unflagged))
+      await xerc20.actions
+        .transfer([user, unflagged, `1 ${symbol}`, ''])
+        .send(active(user))
+    })
+  })
+
+  describe('lockbox reglockbox -> routes', () => {
+    const token = 'tkn.token'
+    const xerc20 = 'xtkn.token'
+    const lockbox = 'lockbox'
+    const symbolPrecision = precision(4, 'TKN')
+    const xsymbolPrecision = precision(4, 'XTKN')
+
+    const issuer = 'issuer'
+    const user = 'user'
+
+    const blockchain = new Blockchain()
+    let contracts
+
+    const getBalance = (_contract, _account, _symbol) =>
+      _contract.tables
+        .accounts(getAccountCodeRaw(_account))
+        .getTableRow(getSymbolCodeRaw(_symbol)).balance
+
+    const deposit = _quantity =>
+      contracts.token.actions
+        .transfer([user, lockbox, _quantity, ''])
+        .send(active(user))
+
+    // Pair registered before the routes were introduced
+    before(async () => {
+      blockchain.createAccounts(issuer, user)
+      contracts = {
+        token: deploy(blockchain, token, 'contracts/build/eosio.token'),
+        xerc20: deploy(blockchain, xerc20, 'contracts/build/xerc20.token'),
+        lockbox: deploy(blockchain, lockbox, 'contracts/build/lockbox'),
+      }
+
+      await contracts.token.actions
+        .create([issuer, '500000000.0000 TKN'])
+        .send()
+      await contracts.token.actions
+        .issue([issuer, '1000.0000 TKN', ''])
+        .send(active(issuer))
+      await contracts.token.actions
+        .transfer([issuer, user, '1000.0000 TKN', ''])
+        .send(active(issuer))
+      await contracts.xerc20.actions
+        .create([issuer, '500000000.0000 XTKN'])
+        .send()
+      await contracts.xerc20.actions
+        .setlockbox([lockbox])
+        .send(active(xerc20))
+
+      contracts.lockbox.tables
+        .reglockbox(getAccountCodeRaw(lockbox))
+        .set(getSymbolCodeRaw(symbolPrecision), lockbox, {
+          token,
+          token_symbol: symbolPrecision,
+          xerc20,
+          xerc20_symbol: xsymbolPrecision,
+        })
+    })
+
+    it('Should fallback on reglockbox until migrated', async () => {
+      await deposit('10.0000 TKN')
+
+      expect(getBalance(contracts.xerc20, user, xsymbolPrecision)).to.be.equal(
+        '10.0000 XTKN',
+      )
+      expect(
+        contracts.lockbox.tables.routes(getAccountCodeRaw(token)).getTableRows(),
+      ).to.be.empty
+    })
+
+    it('Should add the routes of the registered pairs', async () => {
+      await contracts.lockbox.actions.migrate([10]).send()
+
+      expect(
+        getActionReturnValue(contracts.lockbox, 'migrate'),
+      ).to.be.deep.equal({ step: 1, migrated: 1, done: true })
+
+      // The collateral already locked is accounted as deposited
+      const wrapRoute = contracts.lockbox.tables
+        .routes(getAccountCodeRaw(token))
+        .getTableRow(getSymbolCodeRaw(symbolPrecision))
+
+      expect(wrapRoute.total).to.be.equal(100000)
+    })
+
+    it('Should use the routes once migrated', async () => {
+      await deposit('5.0000 TKN')
+
+      await contracts.xerc20.actions
+        .transfer([user, lockbox, '15.0000 XTKN', ''])
+        .send(active(user))
+
+      expect(getBalance(contracts.token, user, symbolPrecision)).to.be.equal(
+        '1000.0000 TKN',
+      )
+      expect(getBalance(contracts.xerc20, user, xsymbolPrecision)).to.be.equal(
+        '0.0000 XTKN',
+      )
+
+      const action = contracts.lockbox.actions.migrate([10]).send()
+      await expectToThrow(action, errors.MIGRATION_COMPLETED)
+    })
+  })
+
+  describe('adapter PAM settings v1 -> v2', () => {
+    const adapter = 'adapter'
+    const xerc20 = 'xtkn.token'
+    const issuer = 'issuer'
+    const user = 'user'
+
+    const chainId =
+      'aca376f206b8fc25a6ed44dbdc66547c36c6c33e3a119ffbeaef943642f0e906'
+    const origins = [
+      '0000000000000000000000000000000000000000000000000000000000000001',
+      '0000000000000000000000000000000000000000000000000000000000000038',
+    ]
+    const emitter =
+      '0000000000000000000000005623d0af4bfb6f7b18d6618c166d518e4357cee2'
+    const topicZero =
+      '66756e6473206172652073616675207361667520736166752073616675202e2e'
+
+    const blockchain = new Blockchain()
+    let contract
+
+    // Mappings are keyed by the last 8 bytes of the chain id
+    const getMappingsKey = _chainId => BigInt(`0x${_chainId.slice(48)}`)
+
+    const getConfig = async () => {
+      await contract.actions.getconfig([]).send(active(user))
+      return getActionReturnValue(contract, 'getconfig')
+    }
+
+    before(async () => {
+      blockchain.createAccounts(issuer, user)
+      const token = deploy(blockchain, xerc20, 'contracts/build/xerc20.token')
+      contract = deploy(blockchain, adapter, 'contracts/build/adapter')
+
+      await token.actions.create([issuer, '500000000.0000 XTKN']).send()
+      await contract.actions
+        .create([
+          xerc20,
+          '4,XTKN',
+          '',
+          '18,TKN',
+          origins[0],
+          '0.0018 XTKN',
+        ])
+        .send(active(adapter))
+
+      contract.tables
+        .chainid(getAccountCodeRaw(adapter))
+        .set(getAccountCodeRaw('chainid'), adapter, { chain_id: chainId })
+
+      for (const origin of origins) {
+        contract.tables
+          .mappings(getAccountCodeRaw(adapter))
+          .set(getMappingsKey(origin), adapter, {
+            chain_id: origin,
+            emitter,
+            topic_zero: topicZero,
+          })
+      }
+    })
+
+    it('Should read the legacy settings until migrated', async () => {
+      const config = await getConfig()
+
+      expect(config.local_chain_id).to.be.equal(chainId)
+      expect(config.mappings.map(_m => _m.chain_id)).to.have.members(origins)
+    })
+
+    it('Should migrate the settings in chunks', async () => {
+      await contract.actions.migrate([1]).send(active(adapter))
+
+      // chainid is a single row step
+      expect(getActionReturnValue(contract, 'migrate')).to.be.deep.equal({
+        step: 0,
+        migrated: 1,
+        done: false,
+      })
+      expect(getSingletonInstance(contract, 'chainid2').chain_id).to.be.equal(
+        chainId,
+      )
+      expect(getSingletonInstance(contract, 'chainid')).to.be.undefined
+
+      await contract.actions.migrate([1]).send(active(adapter))
+      await contract.actions.migrate([1]).send(active(adapter))
+
+      expect(getActionReturnValue(contract, 'migrate')).to.be.deep.equal({
+        step: 1,
+        migrated: 3,
+        done: false,
+      })
+
+      // Mixed layouts are still read as a whole
+      const config = await getConfig()
+      expect(config.mappings.map(_m => _m.chain_id)).to.have.members(origins)
+
+      await contract.actions.migrate([10]).send(active(adapter))
+
+      expect(getActionReturnValue(contract, 'migrate')).to.be.deep.equal({
+        step: 2,
+        migrated: 3,
+        done: true,
+      })
+      expect(
+        contract.tables.mappings(getAccountCodeRaw(adapter)).getTableRows(),
+      ).to.be.empty
+    })
+
+    it('Should read the migrated settings', async () => {
+      const config = await getConfig()
+
+      expect(config.local_chain_id).to.be.equal(chainId)
+      expect(config.mappings).to.have.length(2)
+
+      const action = contract.actions.migrate([10]).send(active(adapter))
+      await expectToThrow(action, errors.MIGRATION_COMPLETED)
+    })
+  })
+})
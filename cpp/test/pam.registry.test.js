@@ -0,0 +1,248 @@
+const { Blockchain, expectToThrow } = require('@eosnetwork/vert')
+const { TimePointSec } = require('@wharfkit/antelope')
+const {
+  Chains,
+  ProofcastEventAttestator,
+  Protocols,
+  Versions,
+} = require('@pnetwork/event-attestator')
+const {
+  no0x,
+  deploy,
+  errors,
+  bytes32,
+  getOperation,
+  fromEthersPublicKey,
+} = require('./utils')
+const { expect } = require('chai')
+const { active, getSingletonInstance } = require('./utils/eos-ext')
+const { serializeOperation } = require('./utils/get-operation-sample')
+
+describe('PAM registry testing', () => {
+  const user = 'user'
+  const evil = 'evil'
+  const recipient = 'recipient'
+
+  const TEE_ADDRESS_CHANGE_GRACE_PERIOD_MS = 172800 * 1000
+
+  const pam = {
+    account: 'pam',
+    contract: null,
+  }
+
+  const registry = {
+    account: 'pam.registry',
+    contract: null,
+  }
+
+  // Two adapters sharing the same settings
+  const adapters = [
+    { account: 'adapter', contract: null },
+    { account: 'adapter.two', contract: null },
+  ]
+
+  const privateKey =
+    'dfcc79a57e91c42d7eea05f82a08bd1b7e77f30236bb7c56fe98d3366a1929c4'
+
+  const getEA = _privateKey =>
+    new ProofcastEventAttestator({
+      version: Versions.V1,
+      protocolId: Protocols.Evm,
+      chainId: Chains(Protocols.Evm).Mainnet,
+      privateKey: _privateKey,
+    })
+
+  const ea = getEA(privateKey)
+  const anotherEA = getEA(
+    '8d0e9f7a5a8b2c6e1f3d4a9b7c6e5d4f3a2b1c0d9e8f7a6b5c4d3e2f1a0b9c8d',
+  )
+
+  const publicKey = fromEthersPublicKey(ea.signingKey.compressedPublicKey)
+  const anotherPublicKey = fromEthersPublicKey(
+    anotherEA.signingKey.compressedPublicKey,
+  )
+
+  const evmEmitter = '0x5623D0aF4bfb6F7B18d6618C166d518E4357ceE2'
+  const evmTopic0 =
+    '0x66756e6473206172652073616675207361667520736166752073616675202e2e'
+  const EOSChainId =
+    'aca376f206b8fc25a6ed44dbdc66547c36c6c33e3a119ffbeaef943642f0e906'
+
+  const attestation = []
+  const blockchain = new Blockchain()
+
+  let operation = getOperation({
+    blockId:
+      '0x21d41bf94358b9252115aee1eb250ef5a644e7fae776b3de508aacda5f4c26fc',
+    txId: '0x6be2de7375ad7c18fd5ca3ecc8b70e60c535750b042200070dc36f84175a16d6',
+    nonce: 0,
+    token: '0xf2e246bb76df876cef8b38ae84130f4f55de395b',
+    originChainId: Chains(Protocols.Evm).Mainnet,
+    destinationChainId: Chains(Protocols.Eos).Mainnet,
+    amount: 13,
+    sender: '0x2b5ad5c4795c026514f8317c7a215e218dccd6cf',
+    recipient,
+    data: '',
+  })
+
+  const data = serializeOperation(operation)
+
+  operation = no0x(operation)
+
+  const event = {
+    blockHash: operation.blockId,
+    transactionHash: operation.txId,
+    address: evmEmitter,
+    topics: [evmTopic0],
+    data,
+  }
+
+  const getMetadata = _ea =>
+    no0x({
+      signature: _ea.formatEosSignature(_ea.sign(event)),
+      preimage: _ea.getEventPreImage(event),
+    })
+
+  const expectedEventId =
+    '861a9d4acfb2eb75c8093e39ec0af1be4d20a789003c6ec9d2508b2ff1247843'
+
+  const isAuthorized = async (_adapter, _metadata) => {
+    await pam.contract.actions
+      .setadapter([_adapter.account])
+      .send(active(pam.account))
+
+    return pam.contract.actions
+      .isauthorized([operation, _metadata])
+      .send(active(user))
+  }
+
+  before(async () => {
+    blockchain.createAccounts(user, evil, recipient)
+    pam.contract = deploy(blockchain, pam.account, 'contracts/build/test.pam')
+    registry.contract = deploy(
+      blockchain,
+      registry.account,
+      'contracts/build/pam.registry',
+    )
+
+    for (const adapter of adapters) {
+      adapter.contract = deploy(
+        blockchain,
+        adapter.account,
+        'contracts/build/adapter',
+      )
+    }
+  })
+
+  describe('pam.registry settings', () => {
+    it('Should throw if called by not authorized account', async () => {
+      const action = registry.contract.actions
+        .setchainid([EOSChainId])
+        .send(active(evil))
+
+      await expectToThrow(action, errors.AUTH_MISSING(registry.account))
+    })
+
+    it('Should set the shared settings', async () => {
+      await registry.contract.actions
+        .setchainid([EOSChainId])
+        .send(active(registry.account))
+
+      await registry.contract.actions
+        .settee([publicKey, attestation])
+        .send(active(registry.account))
+
+      await registry.contract.actions
+        .setorigin([
+          operation.originChainId,
+          no0x(bytes32(evmEmitter)),
+          no0x(evmTopic0),
+        ])
+        .send(active(registry.account))
+
+      const tee = getSingletonInstance(registry.contract, 'tee')
+      expect(tee.key).to.be.equal(publicKey.toString())
+      expect(
+        getSingletonInstance(registry.contract, 'chainid2').chain_id,
+      ).to.be.equal(EOSChainId)
+    })
+  })
+
+  describe('adapter::setregistry', () => {
+    it('Should throw if called by not authorized account', async () => {
+      const action = adapters[0].contract.actions
+        .setregistry([registry.account])
+        .send(active(evil))
+
+      await expectToThrow(action, errors.AUTH_MISSING(adapters[0].account))
+    })
+
+    it('Should reject a registry which is not an account', async () => {
+      const action = adapters[0].contract.actions
+        .setregistry(['nonexistent'])
+        .send(active(adapters[0].account))
+
+      await expectToThrow(action, errors.INVALID_REGISTRY)
+    })
+
+    it('Should use its own settings when the registry is not set', async () => {
+      const action = isAuthorized(adapters[0], getMetadata(ea))
+
+      await expectToThrow(action, errors.LOCAL_CHAIN_NOT_SET)
+    })
+
+    it('Should authorize through the shared settings', async () => {
+      for (const adapter of adapters) {
+        await adapter.contract.actions
+          .setregistry([registry.account])
+          .send(active(adapter.account))
+
+        await isAuthorized(adapter, getMetadata(ea))
+
+        expect(pam.contract.bc.console).to.be.equal(expectedEventId)
+      }
+    })
+
+    it('Should rotate the TEE key of all the adapters at once', async () => {
+      await registry.contract.actions
+        .settee([anotherPublicKey, attestation])
+        .send(active(registry.account))
+
+      const action = registry.contract.actions
+        .applynewtee([])
+        .send(active(registry.account))
+
+      await expectToThrow(action, errors.GRACE_PERIOD_NOT_ELAPSED)
+
+      blockchain.setTime(
+        TimePointSec.fromMilliseconds(
+          Date.now() + TEE_ADDRESS_CHANGE_GRACE_PERIOD_MS,
+        ),
+      )
+
+      await registry.contract.actions
+        .applynewtee([])
+        .send(active(registry.account))
+
+      for (const adapter of adapters) {
+        await expectToThrow(
+          isAuthorized(adapter, getMetadata(ea)),
+          errors.INVALID_SIGNATURE,
+        )
+
+        await isAuthorized(adapter, getMetadata(anotherEA))
+        expect(pam.contract.bc.console).to.be.equal(expectedEventId)
+      }
+    })
+
+    it('Should switch back to its own settings', async () => {
+      await adapters[0].contract.actions
+        .setregistry([''])
+        .send(active(adapters[0].account))
+
+      const action = isAuthorized(adapters[0], getMetadata(anotherEA))
+
+      await expectToThrow(action, errors.LOCAL_CHAIN_NOT_SET)
+    })
+  })
+})
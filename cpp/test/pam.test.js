@@ -307,7 +307,7 @@ describe('PAM testing', () => {
           .isauthorized([wrongOperation, metadata])
           .send(active(user))
 
-        await expectToThrow(action, errors.ACCOUNT_STR_IS_TOO_LONG)
+        await expectToThrow(action, errors.INVALID_RECIPIENT)
       })
 
       it('Should reject when the recipient is an invalid account', async () => {
@@ -416,5 +416,57 @@ describe('PAM testing', () => {
         '190635fc5b0d1b2704567e7a1d379dcf9604119fded50de105a1e77f381d3a0e'
       expect(pam.contract.bc.console).to.be.equal(expectedEventId)
     })
+
+    it('Should authorize an EOSIO operation attested in binary form', async () => {
+      let eosOperation = getOperation({
+        local: true,
+        nonce: 1,
+        blockId:
+          '179ed57f474f446f2c9f6ea6702724cdad0cf26422299b368755ed93c0134a35',
+        txId: '27598a45ee610287d85695f823f8992c10602ce5bf3240ee20635219de4f734f',
+        token: '4,TKN',
+        originChainId: Chains(Protocols.EosBinary).Jungle,
+        destinationChainId: Chains(Protocols.Eos).Mainnet,
+        amount: 9.9825,
+        sender: 'user',
+        recipient: 'recipient',
+        data: '',
+      })
+
+      const eventData = {
+        event_bytes: no0x(serializeOperation(eosOperation)),
+      }
+
+      eosOperation = no0x(eosOperation)
+
+      const eosEA = new ProofcastEventAttestator({
+        version: Versions.V1,
+        protocolId: Protocols.EosBinary,
+        chainId: Chains(Protocols.EosBinary).Jungle,
+        privateKey,
+      })
+
+      const eosEvent = {
+        blockHash: eosOperation.blockId,
+        transactionHash: eosOperation.txId,
+        account: 'adapter',
+        action: 'swap',
+        data: eventData,
+      }
+
+      // Origin already registered by the previous test
+      const eosMetadata = {
+        signature: no0x(eosEA.formatEosSignature(eosEA.sign(eosEvent))),
+        preimage: no0x(eosEA.getEventPreImage(eosEvent)),
+      }
+
+      await pam.contract.actions
+        .isauthorized([eosOperation, eosMetadata])
+        .send(active(user))
+
+      expect(pam.contract.bc.console).to.be.equal(
+        no0x(eosEA.getEventId(eosEvent)),
+      )
+    })
   })
 })
@@ -1,6 +1,6 @@
 const R = require('ramda')
 
-const { Asset, Name } = require('@wharfkit/antelope')
+const { Asset, Name, Serializer } = require('@wharfkit/antelope')
 const { Symbol } = Asset
 
 const active = _account => `${_account}@active`
@@ -17,6 +17,26 @@ const precision = R.curry((_precision, _symbol) => `${_precision},${_symbol}`)
 const getSingletonInstance = (_contract, _tableName) =>
   _contract.tables[_tableName]().getTableRow(getAccountCodeRaw(_tableName))
 
+// Decode the value returned by the last execution
+// of the given action through the contract ABI
+const getActionReturnValue = (_contract, _action) => {
+  const trace = R.findLast(
+    _trace => _trace.action.toString() === _action,
+    _contract.bc.executionTraces,
+  )
+  const { result_type } = _contract.abi.action_results.find(
+    _result => _result.name.toString() === _action,
+  )
+
+  return Serializer.objectify(
+    Serializer.decode({
+      data: trace.returnValue,
+      type: result_type,
+      abi: _contract.abi,
+    }),
+  )
+}
+
 const prettyTrace = _trace => ({
   Contract: _trace.contract.toString(),
   Action: _trace.action.toString(),
@@ -42,4 +62,5 @@ module.exports = {
   getAccountCodeRaw,
   logExecutionTraces,
   getSingletonInstance,
+  getActionReturnValue,
 }
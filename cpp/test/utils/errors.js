@@ -9,6 +9,7 @@ const INSUFFICIENT_BALANCE_INC = eosio_assert(
   '[increase allowance]: balance is lower than the allowance to be set',
 )
 const NO_ALLOWANCE_SET = eosio_assert('No allowance set for this node')
+const TOKEN_SYMBOL_MISMATCH = eosio_assert('symbol and token do not match')
 
 const AUTH_MISSING = _account => `missing required authority ${_account}`
 
@@ -81,6 +82,14 @@ const GRACE_PERIOD_NOT_ELAPSED = eosio_assert('grace period not elapsed')
 
 const EVENT_ALREADY_PROCESSED = eosio_assert('event already processed')
 
+const NOT_ENOUGH_MINTING_LIMITS = eosio_assert(
+  'xerc20_assert: not high enough limits',
+)
+
+const MIGRATION_COMPLETED = eosio_assert('migration already completed')
+
+const INVALID_REGISTRY = eosio_assert('registry must be a valid account')
+
 module.exports = {
   AUTH_MISSING,
   SYMBOL_NOT_FOUND,
@@ -89,6 +98,7 @@ module.exports = {
   INSUFFICIENT_BALANCE_SET,
   INSUFFICIENT_BALANCE_INC,
   NO_ALLOWANCE_SET,
+  TOKEN_SYMBOL_MISMATCH,
   FROM_ACCOUNT_IS_FROZEN,
   TO_ACCOUNT_IS_FROZEN,
   INVALID_TOKEN,
@@ -120,4 +130,7 @@ module.exports = {
   CONTRACT_ALREADY_INITIALIZED,
   GRACE_PERIOD_NOT_ELAPSED,
   EVENT_ALREADY_PROCESSED,
+  NOT_ENOUGH_MINTING_LIMITS,
+  MIGRATION_COMPLETED,
+  INVALID_REGISTRY,
 }
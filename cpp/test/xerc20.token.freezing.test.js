@@ -2,7 +2,12 @@ const { expect } = require('chai')
 const { deploy } = require('./utils/deploy')
 const { getSingletonInstance } = require('./utils/eos-ext')
 const { Blockchain, expectToThrow } = require('@eosnetwork/vert')
-const { active, getAccountCodeRaw, precision } = require('./utils/eos-ext')
+const {
+  active,
+  getAccountCodeRaw,
+  getSymbolCodeRaw,
+  precision,
+} = require('./utils/eos-ext')
 const errors = require('./utils/errors')
 const { substract } = require('./utils/wharfkit-ext')
 const { getAccountsBalances } = require('./utils/get-token-balance')
@@ -126,6 +131,12 @@ describe('xerc20.token - Freezing capabilities tests', () => {
         .getTableRow(getAccountCodeRaw(evil))
 
       expect(rows.account).to.be.equal(evil)
+
+      const balanceRow = xerc20.contract.tables
+        .accounts(getAccountCodeRaw(evil))
+        .getTableRow(getSymbolCodeRaw(Asset.from(xerc20.maxSupply)))
+
+      expect(balanceRow.frozen).to.be.true
     })
 
     it('Should not able to transfer/receive funds after freezing', async () => {
@@ -181,6 +192,53 @@ describe('xerc20.token - Freezing capabilities tests', () => {
         .getTableRow(getAccountCodeRaw(evil))
 
       expect(rows).to.be.undefined
+
+      const balanceRow = xerc20.contract.tables
+        .accounts(getAccountCodeRaw(evil))
+        .getTableRow(getSymbolCodeRaw(Asset.from(xerc20.maxSupply)))
+
+      expect(balanceRow.frozen).to.be.undefined
+    })
+
+    it('Should flag the balance rows created after freezing', async () => {
+      const amount = `1.0000 ${xerc20.symbol}`
+      await xerc20.contract.actions.freeze([user]).send(active(freezingAccount))
+
+      await xerc20.contract.actions
+        .mint([xerc20.account, user, amount, memo])
+        .send(active(xerc20.account))
+
+      const balanceRow = xerc20.contract.tables
+        .accounts(getAccountCodeRaw(user))
+        .getTableRow(getSymbolCodeRaw(Asset.from(xerc20.maxSupply)))
+
+      expect(balanceRow.frozen).to.be.true
+
+      const action = xerc20.contract.actions
+        .transfer([user, recipient, amount, memo])
+        .send(active(user))
+
+      await expectToThrow(action, errors.FROM_ACCOUNT_IS_FROZEN)
+
+      await xerc20.contract.actions
+        .unfreeze([user])
+        .send(active(freezingAccount))
+
+      await xerc20.contract.actions
+        .transfer([user, recipient, amount, memo])
+        .send(active(user))
+    })
+
+    it('Only the contract can sync the frozen flags', async () => {
+      const action = xerc20.contract.actions
+        .syncfrozen([user])
+        .send(active(evil))
+
+      await expectToThrow(action, errors.AUTH_MISSING(xerc20.account))
+
+      await xerc20.contract.actions
+        .syncfrozen([user])
+        .send(active(xerc20.account))
     })
   })
 })
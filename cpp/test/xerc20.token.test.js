@@ -2,18 +2,15 @@ const { expect } = require('chai')
 const { Blockchain, expectToThrow } = require('@eosnetwork/vert')
 const { deploy } = require('./utils/deploy')
 const { Asset, TimePointSec } = require('@wharfkit/antelope')
-const { substract } = require('./utils/wharfkit-ext')
 const {
   active,
   getSymbolCodeRaw,
   getAccountCodeRaw,
+  getActionReturnValue,
   precision,
 } = require('./utils/eos-ext')
 const errors = require('./utils/errors')
 
-const round = (_value, _decimals) =>
-  Math.round(_value * 10 ** _decimals) / 10 ** _decimals
-
 describe('xerc20.token', () => {
   const symbol = 'TKN'
   const symbolPrecision = precision(0, symbol)
@@ -21,6 +18,7 @@ describe('xerc20.token', () => {
   const maxSupply = Asset.from(500000000, symbolPrecision)
   const blockchain = new Blockchain()
   const DURATION = 24 * 60 * 60 // 1 day
+  const RATE_PRECISION_BITS = 16
 
   const evil = 'evil'
   const issuer = 'issuer'
@@ -44,6 +42,7 @@ describe('xerc20.token', () => {
       supply: `0 ${symbol}`,
       max_supply: maxSupply.toString(),
       issuer: issuer,
+      frozen_flags: true,
     })
   })
 
@@ -73,34 +72,75 @@ describe('xerc20.token', () => {
     blockchain.setTime(timestamp)
     await xerc20.actions.setlimits([bridge, mintingLimit, burningLimit]).send()
 
-    const scope = getAccountCodeRaw(account)
+    const scope = getSymbolCodeRaw(maxSupply)
     const primaryKey = getAccountCodeRaw(bridge)
-    const rows = xerc20.tables.bridges(scope).getTableRows(primaryKey)
+    const rows = xerc20.tables.limits(scope).getTableRows(primaryKey)
 
     const expectedTimestamp = timestamp.toMilliseconds() / 1000
-    const expectedMintingRate = round(
-      Asset.from(mintingLimit).value / DURATION,
-      7,
-    ).toString()
-    const expectedBurningRate = round(
-      Asset.from(burningLimit).value / DURATION,
-      7,
-    ).toString()
+    const expectedLimit = _limit => ({
+      timestamp: expectedTimestamp,
+      rate: Math.floor((_limit * 2 ** RATE_PRECISION_BITS) / DURATION),
+      current: _limit,
+      max: _limit,
+    })
 
     expect(rows).to.have.length(1)
     expect(rows[0]).to.be.deep.equal({
       account: bridge,
-      minting_timestamp: expectedTimestamp,
-      minting_rate: expectedMintingRate,
-      minting_current_limit: mintingLimit,
-      minting_max_limit: mintingLimit,
-      burning_timestamp: expectedTimestamp,
-      burning_rate: expectedBurningRate,
-      burning_current_limit: burningLimit,
-      burning_max_limit: burningLimit,
+      minting: expectedLimit(Asset.from(mintingLimit).units.toNumber()),
+      burning: expectedLimit(Asset.from(burningLimit).units.toNumber()),
+      minted: 0,
+      burned: 0,
+    })
+  })
+
+  it('Should set the limits for the same bridge on another symbol', async () => {
+    const anotherMaxSupply = Asset.from(1000, precision(0, 'ANOTHER'))
+    await xerc20.actions.create([issuer, anotherMaxSupply]).send()
+
+    await xerc20.actions.setlimits([bridge, '10 ANOTHER', '5 ANOTHER']).send()
+
+    const primaryKey = getAccountCodeRaw(bridge)
+    const rows = xerc20.tables
+      .limits(getSymbolCodeRaw(anotherMaxSupply))
+      .getTableRows(primaryKey)
+    const tknRows = xerc20.tables
+      .limits(getSymbolCodeRaw(maxSupply))
+      .getTableRows(primaryKey)
+
+    expect(rows).to.have.length(1)
+    expect(rows[0].minting.max).to.be.equal(10)
+    expect(rows[0].burning.max).to.be.equal(5)
+    expect(tknRows[0].minting.max).to.be.equal(1000)
+    expect(tknRows[0].burning.max).to.be.equal(600)
+  })
+
+  it('Should revert when migrating the bridges without authorization', async () => {
+    const action = xerc20.actions.migrate([10]).send(active(evil))
+    await expectToThrow(action, errors.AUTH_MISSING(account))
+  })
+
+  it('Should leave the limits untouched when there is nothing to migrate', async () => {
+    const scope = getSymbolCodeRaw(maxSupply)
+    const primaryKey = getAccountCodeRaw(bridge)
+    const before = xerc20.tables.limits(scope).getTableRows(primaryKey)
+
+    await xerc20.actions.migrate([10]).send()
+
+    const after = xerc20.tables.limits(scope).getTableRows(primaryKey)
+    expect(after).to.be.deep.equal(before)
+    expect(getActionReturnValue(xerc20, 'migrate')).to.be.deep.equal({
+      step: 2,
+      migrated: 0,
+      done: true,
     })
   })
 
+  it('Should revert when the migration is already completed', async () => {
+    const action = xerc20.actions.migrate([10]).send()
+    await expectToThrow(action, errors.MIGRATION_COMPLETED)
+  })
+
   // TODO: add test reverting when the bridge is not whitelisted (MINT/BURN)
   it('Should revert when the account minting tokens is not authorized', async () => {
     const memo = ''
@@ -119,7 +159,7 @@ describe('xerc20.token', () => {
     blockchain.setTime(timestamp)
 
     const bridgeLimitsBefore = xerc20.tables
-      .bridges(getAccountCodeRaw(account))
+      .limits(getSymbolCodeRaw(maxSupply))
       .getTableRows(getAccountCodeRaw(bridge))
 
     await xerc20.actions
@@ -131,21 +171,18 @@ describe('xerc20.token', () => {
       .getTableRow(getSymbolCodeRaw(maxSupply))
 
     const bridgeLimits = xerc20.tables
-      .bridges(getAccountCodeRaw(account))
+      .limits(getSymbolCodeRaw(maxSupply))
       .getTableRows(getAccountCodeRaw(bridge))
     const expectedTimestamp = timestamp.toMilliseconds() / 1000
 
-    const difference = substract(
-      bridgeLimitsBefore[0].minting_current_limit,
-      quantity,
-    )
+    const difference =
+      bridgeLimitsBefore[0].minting.current -
+      Asset.from(quantity).units.toNumber()
 
     expect(balance).to.be.deep.equal({ balance: quantity })
     expect(bridgeLimits).to.have.length(1)
-    expect(bridgeLimits[0].minting_current_limit).to.be.equal(
-      String(difference),
-    )
-    expect(bridgeLimits[0].minting_timestamp).to.be.equal(expectedTimestamp)
+    expect(bridgeLimits[0].minting.current).to.be.equal(difference)
+    expect(bridgeLimits[0].minting.timestamp).to.be.equal(expectedTimestamp)
   })
 
   it('Should revert when the account burning is not authorized', async () => {
@@ -164,7 +201,7 @@ describe('xerc20.token', () => {
     const quantity = `10 ${symbol}`
 
     const bridgeLimitsBefore = xerc20.tables
-      .bridges(getAccountCodeRaw(account))
+      .limits(getSymbolCodeRaw(maxSupply))
       .getTableRows(getAccountCodeRaw(bridge))
 
     await xerc20.actions
@@ -174,22 +211,310 @@ describe('xerc20.token', () => {
     await xerc20.actions.burn([bridge, quantity, memo]).send(active(bridge))
 
     const bridgeLimits = xerc20.tables
-      .bridges(getAccountCodeRaw(account))
+      .limits(getSymbolCodeRaw(maxSupply))
       .getTableRows(getAccountCodeRaw(bridge))
 
     const scope = getAccountCodeRaw(recipient)
     const primaryKey = getSymbolCodeRaw(maxSupply)
     const row = xerc20.tables.accounts(scope).getTableRow(primaryKey)
-    const difference = substract(
-      bridgeLimitsBefore[0].burning_current_limit,
-      quantity,
-    )
+    const difference =
+      bridgeLimitsBefore[0].burning.current -
+      Asset.from(quantity).units.toNumber()
 
     expect(row).to.be.deep.equal({
       balance: `0 ${symbol}`,
     })
-    expect(bridgeLimits[0].burning_current_limit).to.be.equal(
-      String(difference),
-    )
+    expect(bridgeLimits[0].burning.current).to.be.equal(difference)
+  })
+  describe('xtoken::mintbatch', () => {
+    const memo = ''
+    const timestamp = TimePointSec.fromMilliseconds(1726133966067)
+
+    it('Should mint to many recipients with a single limit update', async () => {
+      blockchain.setTime(timestamp)
+
+      const limitsTable = xerc20.tables.limits(getSymbolCodeRaw(maxSupply))
+      const before = limitsTable.getTableRows(getAccountCodeRaw(bridge))
+      const supplyBefore = Asset.from(
+        xerc20.tables
+          .stat(getSymbolCodeRaw(maxSupply))
+          .getTableRow(getSymbolCodeRaw(maxSupply)).supply,
+      )
+
+      await xerc20.actions
+        .mintbatch([
+          bridge,
+          [
+            { to: recipient, quantity: `5 ${symbol}`, memo },
+            { to: issuer, quantity: `7 ${symbol}`, memo },
+          ],
+        ])
+        .send(active(bridge))
+
+      const after = limitsTable.getTableRows(getAccountCodeRaw(bridge))
+      const supplyAfter = Asset.from(
+        xerc20.tables
+          .stat(getSymbolCodeRaw(maxSupply))
+          .getTableRow(getSymbolCodeRaw(maxSupply)).supply,
+      )
+      const balanceOf = _account =>
+        xerc20.tables
+          .accounts(getAccountCodeRaw(_account))
+          .getTableRow(getSymbolCodeRaw(maxSupply))
+
+      expect(after[0].minting.current).to.be.equal(
+        before[0].minting.current - 12,
+      )
+      expect(supplyAfter.units.toNumber()).to.be.equal(
+        supplyBefore.units.toNumber() + 12,
+      )
+      expect(balanceOf(recipient)).to.be.deep.equal({
+        balance: `5 ${symbol}`,
+      })
+      expect(balanceOf(issuer)).to.be.deep.equal({ balance: `7 ${symbol}` })
+    })
+
+    it('Should check the limits against the batch total', async () => {
+      const action = xerc20.actions
+        .mintbatch([
+          bridge,
+          [
+            { to: recipient, quantity: `500 ${symbol}`, memo },
+            { to: issuer, quantity: `500 ${symbol}`, memo },
+          ],
+        ])
+        .send(active(bridge))
+
+      await expectToThrow(action, errors.NOT_ENOUGH_MINTING_LIMITS)
+    })
+  })
+  describe('xtoken::burnfee', () => {
+    const memo = ''
+
+    it('Should pay the fee and burn the rest in one action', async () => {
+      const scope = getSymbolCodeRaw(maxSupply)
+      const balanceOf = _account =>
+        xerc20.tables.accounts(getAccountCodeRaw(_account)).getTableRow(scope)
+      const supplyOf = () =>
+        Asset.from(xerc20.tables.stat(scope).getTableRow(scope).supply)
+
+      await xerc20.actions
+        .transfer([recipient, bridge, `5 ${symbol}`, memo])
+        .send(active(recipient))
+
+      const limitsBefore = xerc20.tables
+        .limits(scope)
+        .getTableRows(getAccountCodeRaw(bridge))
+      const supplyBefore = supplyOf()
+      const feeRecipientBefore = Asset.from(balanceOf(issuer).balance)
+
+      await xerc20.actions
+        .burnfee([bridge, `5 ${symbol}`, issuer, `2 ${symbol}`])
+        .send(active(bridge))
+
+      const limitsAfter = xerc20.tables
+        .limits(scope)
+        .getTableRows(getAccountCodeRaw(bridge))
+
+      const feeRecipientAfter = Asset.from(balanceOf(issuer).balance)
+
+      expect(balanceOf(bridge)).to.be.deep.equal({ balance: `0 ${symbol}` })
+      expect(feeRecipientAfter.units.toNumber()).to.be.equal(
+        feeRecipientBefore.units.toNumber() + 2,
+      )
+      expect(supplyOf().units.toNumber()).to.be.equal(
+        supplyBefore.units.toNumber() - 3,
+      )
+      expect(limitsAfter[0].burning.current).to.be.equal(
+        limitsBefore[0].burning.current - 3,
+      )
+    })
+  })
+  describe('xtoken read-only actions', () => {
+    const scope = getSymbolCodeRaw(maxSupply)
+    const accounts = [recipient, issuer, evil]
+    const balanceOf = _account => {
+      const row = xerc20.tables
+        .accounts(getAccountCodeRaw(_account))
+        .getTableRow(scope)
+      return row ? row.balance : `0 ${symbol}`
+    }
+
+    it('Should return the balances of many accounts', async () => {
+      await xerc20.actions.getbalances([symbol, accounts]).send(active(evil))
+
+      expect(getActionReturnValue(xerc20, 'getbalances')).to.be.deep.equal(
+        accounts.map(balanceOf),
+      )
+    })
+
+    it('Should return the bridges headroom at the current time', async () => {
+      const [row] = xerc20.tables
+        .limits(scope)
+        .getTableRows(getAccountCodeRaw(bridge))
+
+      await xerc20.actions.getheadroom([symbol]).send(active(evil))
+
+      // No time passed since the last mint/burn
+      expect(getActionReturnValue(xerc20, 'getheadroom')).to.be.deep.equal([
+        {
+          account: bridge,
+          minting: `${row.minting.current} ${symbol}`,
+          burning: `${row.burning.current} ${symbol}`,
+          minting_max: `${row.minting.max} ${symbol}`,
+          burning_max: `${row.burning.max} ${symbol}`,
+        },
+      ])
+    })
+
+    it('Should return the supply and the frozen status', async () => {
+      const stat = xerc20.tables.stat(scope).getTableRow(scope)
+
+      await xerc20.actions.getstatus([symbol, accounts]).send(active(evil))
+
+      expect(getActionReturnValue(xerc20, 'getstatus')).to.be.deep.equal({
+        supply: stat.supply,
+        max_supply: stat.max_supply,
+        frozen: [false, false, false],
+      })
+    })
+  })
+  describe('xtoken supply checkpoints', () => {
+    const memo = ''
+    const scope = getSymbolCodeRaw(maxSupply)
+    const quantity = `1 ${symbol}`
+    const toUnits = _asset => Asset.from(_asset).units.toNumber()
+
+    it('Should revert when enabling the checkpoints without authorization', async () => {
+      const action = xerc20.actions
+        .setcheckpts([symbol, 2, 1])
+        .send(active(evil))
+
+      await expectToThrow(action, errors.AUTH_MISSING(account))
+    })
+
+    it('Should keep the last checkpoints in the ring', async () => {
+      const stat = xerc20.tables.stat(scope).getTableRow(scope)
+      const supply = toUnits(stat.supply)
+      const [limitsBefore] = xerc20.tables
+        .limits(scope)
+        .getTableRows(getAccountCodeRaw(bridge))
+
+      await xerc20.actions.setcheckpts([symbol, 2, 1]).send()
+
+      await xerc20.actions
+        .mint([bridge, bridge, quantity, memo])
+        .send(active(bridge))
+      await xerc20.actions.burn([bridge, quantity, memo]).send(active(bridge))
+      await xerc20.actions
+        .mint([bridge, recipient, quantity, memo])
+        .send(active(bridge))
+
+      await xerc20.actions.getcheckpts([symbol]).send(active(evil))
+
+      const result = getActionReturnValue(xerc20, 'getcheckpts')
+      const withoutBlock = ({ supply, minted, burned }) => ({
+        supply,
+        minted,
+        burned,
+      })
+
+      // Counted since the ring was enabled
+      expect(withoutBlock(result.current)).to.be.deep.equal({
+        supply: supply + 1,
+        minted: 2,
+        burned: 1,
+      })
+      expect(result.checkpoints.map(withoutBlock)).to.be.deep.equal([
+        { supply, minted: 1, burned: 1 },
+        { supply: supply + 1, minted: 2, burned: 1 },
+      ])
+
+      const [limitsAfter] = xerc20.tables
+        .limits(scope)
+        .getTableRows(getAccountCodeRaw(bridge))
+
+      expect(limitsAfter.minted).to.be.equal(limitsBefore.minted + 2)
+      expect(limitsAfter.burned).to.be.equal(limitsBefore.burned + 1)
+    })
+  })
+  describe('xtoken integrated lockbox', () => {
+    const memo = ''
+    const underlying = {
+      account: 'undrly.token',
+      symbol: 'UND',
+      contract: null,
+    }
+    const scope = getSymbolCodeRaw(maxSupply)
+    const balanceOf = (_contract, _account, _symbol) =>
+      _contract.tables
+        .accounts(getAccountCodeRaw(_account))
+        .getTableRow(getSymbolCodeRaw(Asset.from(`0 ${_symbol}`)))
+
+    before(async () => {
+      underlying.contract = deploy(
+        blockchain,
+        underlying.account,
+        'contracts/build/eosio.token',
+      )
+      await underlying.contract.actions
+        .create([issuer, `1000000 ${underlying.symbol}`])
+        .send()
+      await underlying.contract.actions
+        .issue([issuer, `100 ${underlying.symbol}`, memo])
+        .send(active(issuer))
+      await underlying.contract.actions
+        .transfer([issuer, recipient, `100 ${underlying.symbol}`, memo])
+        .send(active(issuer))
+    })
+
+    it('Should revert when setting the underlying without authorization', async () => {
+      const action = xerc20.actions
+        .setwrap([underlying.account, `0,${underlying.symbol}`, `0,${symbol}`])
+        .send(active(evil))
+
+      await expectToThrow(action, errors.AUTH_MISSING(account))
+    })
+
+    it('Should mint on the underlying token transfer', async () => {
+      await xerc20.actions
+        .setwrap([underlying.account, `0,${underlying.symbol}`, `0,${symbol}`])
+        .send()
+
+      const before = Asset.from(balanceOf(xerc20, recipient, symbol).balance)
+      const supplyBefore = Asset.from(
+        xerc20.tables.stat(scope).getTableRow(scope).supply,
+      )
+
+      await underlying.contract.actions
+        .transfer([recipient, account, `10 ${underlying.symbol}`, memo])
+        .send(active(recipient))
+
+      const after = Asset.from(balanceOf(xerc20, recipient, symbol).balance)
+      const supplyAfter = Asset.from(
+        xerc20.tables.stat(scope).getTableRow(scope).supply,
+      )
+
+      expect(after.units.toNumber()).to.be.equal(before.units.toNumber() + 10)
+      expect(supplyAfter.units.toNumber()).to.be.equal(
+        supplyBefore.units.toNumber() + 10,
+      )
+      expect(
+        balanceOf(underlying.contract, account, underlying.symbol),
+      ).to.be.deep.equal({ balance: `10 ${underlying.symbol}` })
+    })
+
+    it('Should release the collateral on unwrap', async () => {
+      await xerc20.actions
+        .unwrap([recipient, `4 ${symbol}`])
+        .send(active(recipient))
+
+      expect(
+        balanceOf(underlying.contract, account, underlying.symbol),
+      ).to.be.deep.equal({ balance: `6 ${underlying.symbol}` })
+      expect(
+        balanceOf(underlying.contract, recipient, underlying.symbol),
+      ).to.be.deep.equal({ balance: `94 ${underlying.symbol}` })
+    })
   })
 })
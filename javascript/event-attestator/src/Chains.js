@@ -11,6 +11,7 @@ const Chains = _protocolId => {
         Bsc: '0x38',
       }
     case Protocols.Eos:
+    case Protocols.EosBinary:
       return {
         Mainnet:
           '0xaca376f206b8fc25a6ed44dbdc66547c36c6c33e3a119ffbeaef943642f0e906',
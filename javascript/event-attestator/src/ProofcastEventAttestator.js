@@ -55,10 +55,16 @@ class ProofcastEventAttestator {
     return concat([
       zeroPadValue(Buffer.from(event.account, 'utf-8'), 32),
       ...topics,
-      Buffer.from(JSON.stringify(event.data), 'utf-8'),
+      this.isBinaryProtocol()
+        ? this._0x(event.data.event_bytes)
+        : Buffer.from(JSON.stringify(event.data), 'utf-8'),
     ])
   }
 
+  isBinaryProtocol() {
+    return Number(this.protocolId) === Protocols.EosBinary
+  }
+
   getEvmEventPayload(event) {
     // EVM event support only: for other chains may be
     // required to change logic based on version and protocolID
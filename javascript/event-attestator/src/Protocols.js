@@ -3,4 +3,5 @@ module.exports.Protocols = {
   Evm: 0x01,
   Eos: 0x02,
   Algorand: 0x03,
+  EosBinary: 0x04,
 }
@@ -81,4 +81,31 @@ describe('Proofcast Event Attestator Tests', () => {
       expectedSignature,
     )
   })
+
+  it('Should carry the raw event bytes for the EOS binary protocol', async () => {
+    const eventBytes =
+      '0000000000000000000000000000000000000000000000000000000000000000'
+    const event = {
+      blockHash:
+        '179ed57f474f446f2c9f6ea6702724cdad0cf26422299b368755ed93c0134a35',
+      transactionHash:
+        '27598a45ee610287d85695f823f8992c10602ce5bf3240ee20635219de4f734f',
+      account: 'adapter',
+      action: 'swap',
+      data: { event_bytes: eventBytes },
+    }
+
+    const ea = new ProofcastEventAttestator({
+      version: Versions.V1,
+      protocolId: Protocols.EosBinary,
+      chainId: Chains(Protocols.EosBinary).Mainnet,
+      privateKey,
+    })
+
+    const preimage = ea.getEventPreImage(event)
+
+    expect(preimage.slice(4, 6)).toStrictEqual('04')
+    expect(preimage.endsWith(eventBytes)).toBe(true)
+    expect((preimage.length - 2) / 2).toStrictEqual(98 + 32 * 5 + 32)
+  })
 })